@@ -19,7 +19,16 @@
 #ifndef _PLUGINOBJECT
 #define _PLUGINOBJECT
 
+#ifdef _WIN32
 #include <windows.h>
+#define POP_UNUSED
+#else
+// only what the plugin interfaces need from windows.h, for non-Windows builds
+#define __cdecl
+typedef void *HWND;
+// POPTypeNames below is defined in every file that includes this, used or not
+#define POP_UNUSED __attribute__((unused))
+#endif
 
 
 // forward referencing stuff
@@ -65,7 +74,7 @@ enum POPType
   POPTYPE_STRING,
 };
 
-static char POPTypeNames[3][64] = 
+static char POPTypeNames[3][64] POP_UNUSED = 
 {
   "POPTYPE_INT",
   "POPTYPE_FLOAT",
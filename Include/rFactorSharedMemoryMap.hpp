@@ -4,16 +4,28 @@ by Dan Allongo (daniel.s.allongo@gmail.com)
 
 This remains largely unchanged from Example.hpp, except for a few additional 
 private variables to track the current state of the memory map handle and buffer.
+OS specifics live behind rfPlatform.hpp.
 */
 
 #pragma once
 
 #include "InternalsPlugin.hpp"
 #include "rfSharedStruct.hpp"
-#include <Windows.h>
-#include <time.h>
+#include "rfPlatform.hpp"
+#include "rfInterpolate.hpp"
+#include "rfRecorder.hpp"
+#include "rfSchema.hpp"
+#include "rfTrack.hpp"
+#include "rfGaps.hpp"
+#include "rfStandings.hpp"
+#include "rfStrings.hpp"
 
 #define PLUGIN_NAME "rFactorSharedMemoryMap"
+#define PLUGIN_RECORD_DIR_VAR "RFSHARED_RECORD_DIR"  // environment variable naming a directory to record sessions into
+#define PLUGIN_RECORD_MAX_SUFFIX 99                  // highest -N tried when a session's capture name is taken
+#define PLUGIN_TRACK_DIR_VAR "RFSHARED_TRACK_DIR"    // environment variable naming a directory to cache learned track lines in
+#define PLUGIN_TRACK_DIR_DEFAULT "UserData"         // used when PLUGIN_TRACK_DIR_VAR isn't set
+#define PLUGIN_VEHICLES_VAR "RFSHARED_VEHICLES"     // environment variable giving the vehicle segment's capacity, RF_SHARED_MEMORY_MAX_VSI_SIZE if unset
 
 // This is used for app to find out information about the plugin
 class InternalsPluginInfo : public PluginObjectInfo
@@ -39,23 +51,13 @@ class InternalsPluginInfo : public PluginObjectInfo
 };
 
 // internal state tracking
-struct internalVI {
-	float lapDist;
-	rfVec3 pos;
-	rfVec3 localVel;
-	rfVec3 localAccel;
-	rfVec3 oriX;
-	rfVec3 oriY;
-	rfVec3 oriZ;
-	rfVec3 localRot;
-	rfVec3 localRotAccel;
-};
-
 struct internalSI {
+	double scoringTime;
 	float currentET;
+	float lapLength;
 	int numVehicles;
 	char plrFileName[64];
-	internalVI vehicle[RF_SHARED_MEMORY_MAX_VSI_SIZE];
+	rfVehicleStateSoA vehicle;
 };
 
 // This is used for the app to use the plugin for its intended purpose
@@ -71,7 +73,7 @@ class SharedMemoryMapPlugin : public InternalsPluginV3
  public:
 
   // Constructor/destructor
-  SharedMemoryMapPlugin() {}
+  SharedMemoryMapPlugin() : pBuf(NULL), mapped(false), pHistory(NULL), pTelemetry(NULL), pScoring(NULL), pVehicles(NULL), pSession(NULL), pGraphics(NULL), pTrack(NULL), pStrings(NULL), pState(NULL), pStats(NULL), pReaders(NULL), interpolationRequested(false), interpolate(rfSelectInterpolate()), vehicleCapacity(RF_SHARED_MEMORY_MAX_VSI_SIZE), trackedVehicles(RF_SHARED_MEMORY_MAX_VSI_SIZE) {}
   ~SharedMemoryMapPlugin() {}
 
   // Called from class InternalsPluginInfo to return specific information about plugin
@@ -102,8 +104,8 @@ class SharedMemoryMapPlugin : public InternalsPluginV3
   bool WantsTelemetryUpdates() { return( true ); }
   void UpdateTelemetry( const TelemInfoV2 &info );
 
-  bool WantsGraphicsUpdates() { return( false ); }
-  void UpdateGraphics( const GraphicsInfoV2 &info ) {}
+  bool WantsGraphicsUpdates() { return( true ); }
+  void UpdateGraphics( const GraphicsInfoV2 &info );
 
   // GAME INPUT
   bool HasHardwareInputs() { return( false ); }
@@ -124,11 +126,86 @@ class SharedMemoryMapPlugin : public InternalsPluginV3
 
  private:
 
-  HANDLE hMap;
+  void BeginUpdate();     // mark buffer as being written (odd sequence)
+  void EndUpdate();       // mark buffer as consistent (even sequence)
+  void ClearBuffer();     // zero everything but the sequence and the reader line
+  void ResetSession();    // zero the maps and internal state between sessions
+  void StartRecording();  // record the session if PLUGIN_RECORD_DIR_VAR is set
+  void PushHistory();     // append the player telemetry just published to the history ring
+  void CopyTelemetry(rfTelemetryFrame &frame); // copy the player telemetry just published into frame
+  void PublishTelemetrySegment(); // copy the player telemetry just published to its own segment
+  void PublishScoringSegments(const ScoringInfoV2 &info); // copy the scoring just published to the scoring, vehicle and session segments
+  bool InterpolationWanted(); // whether any reader recently asked for vehicle interpolation
+  void PublishScoringState(); // copy the raw scoring state for readers that interpolate themselves
+  void RecordLatency(rfStatsProbe probe, unsigned long long cycles); // add one timed call to the stats map
+  void RefreshStats();    // refresh the cycle counter rate and recorder counters in the stats map
+  void TrackReaders();    // update every registered reader's lag after a telemetry frame
+  void ExpireReaders();   // free the slots of readers that stopped reporting
+  void LearnTrack(const ScoringInfoV2 &info); // feed the vehicles to the track line and publish what changed
+  uint16_t Intern(const char *s); // id of s in the string table, adding it if it's new
+  void ForgetVehicles();  // the maps were cleared, so every vehicle counts as changed again
+
+  rfMapping bufMap;
   rfShared* pBuf;
   bool mapped;
+  uint32_t sequence;
+  rfMapping historyMap;
+  rfHistory* pHistory;
+  rfMapping telemetryMap;
+  rfTelemetrySegment* pTelemetry;
+  uint32_t telemetrySequence;
+  uint32_t telemetryCount;      // telemetry frames published, numbers the frames in every map
+  rfMapping scoringMap;
+  rfScoringSegment* pScoring;
+  uint32_t scoringSequence;
+  rfMapping vehiclesMap;
+  rfVehicleSegment* pVehicles;
+  uint32_t vehiclesSequence;
+  rfMapping sessionMap;
+  rfSessionSegment* pSession;
+  uint32_t sessionSequence;
+  rfMapping graphicsMap;
+  rfGraphicsSegment* pGraphics; // only ever written from UpdateGraphics, which may run on the render thread
+  uint32_t graphicsSequence;
+  uint32_t graphicsCount;
+  rfMapping trackMap;
+  rfTrackSegment* pTrack;
+  uint32_t trackSequence;
+  rfMapping stringsMap;
+  rfStringTable* pStrings;
+  uint32_t stringsSequence;
+  rfMapping stateMap;
+  rfScoringState* pState;
+  uint32_t stateSequence;
+  rfMapping statsMap;
+  rfStats* pStats;
+  uint32_t statsSequence;
+  unsigned long long statsStartCycles;
+  double statsStartTime;
+  rfMapping readersMap;
+  rfReaderTable* pReaders;
+  rfMapping schemaMap;
+  rfSchema* pSchema;
+  uint32_t schemaSequence;
   float cDelta;
-  clock_t cLastScoringUpdate;
   bool inRealtime;
+  bool interpolationRequested;
+  double lastInterpolationRequest;
   internalSI scoring;
+  rfInterpolateFunc interpolate;
+  rfVehicleInterpSoA interp;
+  rfGapEngine gaps;
+  rfStandingsBuilder standings;
+  rfStringInterner strings;
+  int vehicleCapacity;          // entries in the vehicle segment, read once at Startup
+  int trackedVehicles;          // vehicles the plugin keeps track of, enough for the main map and the segment
+  rfVehicleInfo published[RF_SHARED_MEMORY_MAX_VEHICLES]; // the vehicles as scoring last wrote them, diffed against each update
+  int publishedVehicles;
+  uint32_t scoringGeneration;   // scoring updates since the session started
+  uint64_t changedVehicles[RF_SHARED_MEMORY_MAX_VEHICLES / 64]; // entries the last scoring update changed
+  bool vehiclesInterpolated;    // telemetry overwrote the raw values in the maps since the last scoring update
+  rfRecorder recorder;
+  rfTrackLearner track;
+  rfSignal telemetrySignal;     // wakes readers after each telemetry publication
+  rfSignal scoringSignal;       // and after each scoring publication
 };
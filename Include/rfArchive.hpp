@@ -0,0 +1,173 @@
+/*
+rfArchive.hpp
+by Dan Allongo (daniel.s.allongo@gmail.com)
+
+Seekable container for recorded sessions. Holds the same records as a plain
+capture (rfCapture.hpp), but telemetry and scoring payloads are stored as
+byte-run deltas against the previous payload of the same type, with a full
+keyframe of the replay state written periodically and whenever the player
+starts a new lap or sector. A footer indexes every keyframe by capture time,
+session, currentET and lap/sector, so seeking costs a binary search of the
+index and one keyframe decode instead of a scan of the file.
+
+  header | frame... | index entry... | footer
+
+A keyframe frame holds an rfArchiveKeyframe followed by the last telemetry
+and scoring payloads, and resets both delta bases. It is written after the
+record that triggered it, so its state already includes that record. Every
+other frame is one capture record whose payload is either raw (archiveRaw)
+or a sequence of runs { uint16 skip, uint16 length, length bytes } applied
+to the base (archiveDelta).
+
+Captures are converted with rfConvert; rfReplay plays archives and can start
+at any keyframe.
+*/
+
+#pragma once
+
+#include "rfCapture.hpp"
+#include <stdio.h>
+#include <vector>
+
+#define RF_ARCHIVE_MAGIC 0x43524152   // "RARC"
+#define RF_ARCHIVE_VERSION 1
+#define RF_ARCHIVE_KEYFRAME_INTERVAL 10.0 // seconds of session time between periodic keyframes
+
+#define RF_ARCHIVE_KEYFRAME 0x100     // frame type of a keyframe, past every rfCaptureType
+
+typedef enum {
+  archiveRaw = 0,               // payload stored as is
+  archiveDelta = 1              // payload stored as runs against the previous one of its type
+} rfArchiveEncoding;
+
+typedef enum {
+  archiveInSession = 1,         // between StartSession and EndSession
+  archiveInRealtime = 2         // between EnterRealtime and ExitRealtime
+} rfArchiveStateFlags;
+
+#pragma pack(push, 1)
+
+struct rfArchiveHeader {
+  unsigned int magic;           // RF_ARCHIVE_MAGIC
+  unsigned int version;         // RF_ARCHIVE_VERSION
+  rfCaptureHeader capture;      // header of the capture the archive holds
+};
+
+struct rfArchiveFrame {
+  unsigned int type;            // rfCaptureType or RF_ARCHIVE_KEYFRAME
+  unsigned int encoding;        // rfArchiveEncoding
+  unsigned int size;            // bytes stored after this frame
+  unsigned int rawSize;         // payload bytes once decoded
+  double time;                  // seconds since the capture started
+};
+
+struct rfArchiveKeyframe {
+  unsigned int flags;           // rfArchiveStateFlags
+  unsigned int sessions;        // rfArchiveState fields, see below
+  int lap;
+  int sector;
+  double scoringTime;
+  double currentET;
+  unsigned int telemSize;       // telemetry payload bytes following, 0 if none yet
+  unsigned int scoringSize;     // scoring payload bytes following, 0 if none yet
+};
+
+struct rfArchiveIndexEntry {
+  double time;                  // capture time of the record before the keyframe
+  double currentET;             // sim session time once that record is applied
+  unsigned int session;         // index of the session in the capture, from 0
+  int lap;                      // player's current lap (mTotalLaps + 1)
+  int sector;                   // player's sector, 1 to 3
+  unsigned int reserved;
+  unsigned long long offset;    // file offset of the keyframe
+};
+
+struct rfArchiveFooter {
+  unsigned long long indexOffset; // file offset of the first index entry
+  unsigned int indexCount;
+  unsigned int magic;           // RF_ARCHIVE_MAGIC, so truncated files are spotted
+};
+
+#pragma pack(pop)
+
+// replay state: what a consumer needs to pick up a session part-way through
+struct rfArchiveState {
+  double time;                  // capture time of the last record (or keyframe)
+  unsigned int flags;           // rfArchiveStateFlags
+  unsigned int sessions;        // StartSession records so far
+  int lap;                      // player's mTotalLaps + 1 from the last scoring, 0 if none
+  int sector;                   // player's sector (1 to 3) from the last scoring, 0 if none
+  double scoringTime;           // capture time of the last scoring record
+  double currentET;             // mCurrentET of the last scoring record
+  std::vector<char> telemetry;  // last telemetry payload, empty if none yet
+  std::vector<char> scoring;    // last scoring payload, empty if none yet
+};
+
+class rfArchiveWriter {
+ public:
+  rfArchiveWriter();
+  ~rfArchiveWriter();
+
+  bool Open(const char *path, const rfCaptureHeader &capture, double keyframeInterval = RF_ARCHIVE_KEYFRAME_INTERVAL);
+  bool Write(const rfCaptureRecord &record, const void *payload); // append one capture record
+  bool Close();                 // write the index and footer
+
+  size_t Keyframes() const { return index.size(); }
+
+ private:
+  bool WriteFrame(const rfArchiveFrame &frame, const void *data);
+  bool WriteKeyframe(double time);
+  bool WritePayload(const rfCaptureRecord &record, const void *payload, std::vector<char> &base);
+
+  FILE *f;
+  bool failed;
+  unsigned long long position;  // bytes written so far
+  double interval;
+  double lastKeyframe;          // currentET of the last keyframe
+  rfArchiveState state;         // state after the last record written
+  std::vector<char> encoded;
+  std::vector<rfArchiveIndexEntry> index;
+};
+
+class rfArchiveReader {
+ public:
+  rfArchiveReader();
+  ~rfArchiveReader();
+
+  bool Open(const char *path);  // read the header and index, positioned at the first record
+  void Close();
+
+  const rfCaptureHeader& Capture() const { return header.capture; }
+  const std::vector<rfArchiveIndexEntry>& Index() const { return index; }
+
+  // position at a keyframe, decode it into State() and resume from the record after it
+  // SeekTime and SeekET pick the last keyframe at or before the target, SeekLap
+  // the one where that lap and sector started (or the last one before it)
+  bool Seek(size_t entry);
+  bool SeekTime(double time);
+  bool SeekET(unsigned int session, double currentET);
+  bool SeekLap(unsigned int session, int lap, int sector = 1);
+
+  // next record in capture order, payload decoded into a buffer valid until the next call
+  // keyframes are applied silently
+  bool Next(rfCaptureRecord &record, const void *&payload);
+
+  // state as of the last record returned (or the keyframe just sought to)
+  // a consumer joining part-way replays it as StartSession, EnterRealtime, UpdateScoring, UpdateTelemetry
+  const rfArchiveState& State() const { return state; }
+
+ private:
+  bool SeekBefore(size_t end);  // Seek to the entry before end, if any
+  bool ReadKeyframe(const rfArchiveFrame &frame);
+
+  FILE *f;
+  rfArchiveHeader header;
+  unsigned long long position;  // offset of the next frame
+  unsigned long long dataEnd;   // offset of the index, where the frames stop
+  std::vector<rfArchiveIndexEntry> index;
+  rfArchiveState state;
+  std::vector<char> encoded;
+};
+
+// read just enough of path to tell an archive from a plain capture
+bool rfArchiveDetect(const char *path);
@@ -0,0 +1,250 @@
+/*
+rfCapture.hpp
+by Dan Allongo (daniel.s.allongo@gmail.com)
+
+File format for recorded sessions: a header followed by a stream of records,
+each holding one plugin callback and its payload. Telemetry records carry an
+rfCaptureTelem, scoring records an rfCaptureScoring followed by mNumVehicles
+rfCaptureVehicle.
+
+The payloads mirror the sim's TelemInfoV2, ScoringInfoV2 and
+VehicleScoringInfoV2 with fixed-width members in place of long and the
+pointers, so they are laid out the same by every build: exactly as the 32-bit
+sim passes them, and readable by the 64-bit tools. rfCaptureFrom* and
+rfCaptureTo* translate between the two.
+*/
+
+#pragma once
+
+#include "InternalsPlugin.hpp"
+#include <stdint.h>
+#include <string.h>
+
+#define RF_CAPTURE_MAGIC 0x50414352   // "RCAP"
+#define RF_CAPTURE_VERSION 2
+
+typedef enum {
+  captureStartSession = 0,
+  captureEndSession = 1,
+  captureEnterRealtime = 2,
+  captureExitRealtime = 3,
+  captureTelemetry = 4,
+  captureScoring = 5
+} rfCaptureType;
+
+#pragma pack(push, 1)
+
+struct rfCaptureHeader {
+  unsigned int magic;           // RF_CAPTURE_MAGIC
+  unsigned int version;         // RF_CAPTURE_VERSION
+  unsigned int telemSize;       // sizeof(rfCaptureTelem)
+  unsigned int scoringSize;     // sizeof(rfCaptureScoring)
+  unsigned int vehicleSize;     // sizeof(rfCaptureVehicle)
+};
+
+struct rfCaptureRecord {
+  unsigned int type;            // rfCaptureType
+  unsigned int size;            // payload bytes following this record
+  double time;                  // seconds since the capture started
+};
+
+#pragma pack(pop)
+
+// TelemInfoV2 as recorded
+struct rfCaptureTelem {
+  float mDeltaTime;
+  int32_t mLapNumber;
+  float mLapStartET;
+  char mVehicleName[64];
+  char mTrackName[64];
+  TelemVect3 mPos;
+  TelemVect3 mLocalVel;
+  TelemVect3 mLocalAccel;
+  TelemVect3 mOriX;
+  TelemVect3 mOriY;
+  TelemVect3 mOriZ;
+  TelemVect3 mLocalRot;
+  TelemVect3 mLocalRotAccel;
+  int32_t mGear;
+  float mEngineRPM;
+  float mEngineWaterTemp;
+  float mEngineOilTemp;
+  float mClutchRPM;
+  float mUnfilteredThrottle;
+  float mUnfilteredBrake;
+  float mUnfilteredSteering;
+  float mUnfilteredClutch;
+  float mSteeringArmForce;
+  // TelemInfoV2
+  float mFuel;
+  float mEngineMaxRPM;
+  unsigned char mScheduledStops;
+  bool mOverheating;
+  bool mDetached;
+  unsigned char mDentSeverity[8];
+  float mLastImpactET;
+  float mLastImpactMagnitude;
+  TelemVect3 mLastImpactPos;
+  unsigned char mExpansion[64];
+  TelemWheelV2 mWheel[4];
+};
+
+// VehicleScoringInfoV2 as recorded
+struct rfCaptureVehicle {
+  char mDriverName[32];
+  char mVehicleName[64];
+  short mTotalLaps;
+  signed char mSector;
+  signed char mFinishStatus;
+  float mLapDist;
+  float mPathLateral;
+  float mTrackEdge;
+  float mBestSector1;
+  float mBestSector2;
+  float mBestLapTime;
+  float mLastSector1;
+  float mLastSector2;
+  float mLastLapTime;
+  float mCurSector1;
+  float mCurSector2;
+  short mNumPitstops;
+  short mNumPenalties;
+  // VehicleScoringInfoV2
+  bool mIsPlayer;
+  signed char mControl;
+  bool mInPits;
+  unsigned char mPlace;
+  char mVehicleClass[32];
+  float mTimeBehindNext;
+  int32_t mLapsBehindNext;
+  float mTimeBehindLeader;
+  int32_t mLapsBehindLeader;
+  float mLapStartET;
+  TelemVect3 mPos;
+  TelemVect3 mLocalVel;
+  TelemVect3 mLocalAccel;
+  TelemVect3 mOriX;
+  TelemVect3 mOriY;
+  TelemVect3 mOriZ;
+  TelemVect3 mLocalRot;
+  TelemVect3 mLocalRotAccel;
+  unsigned char mExpansion[128];
+};
+
+// ScoringInfoV2 as recorded, the vehicles follow it
+struct rfCaptureScoring {
+  char mTrackName[64];
+  int32_t mSession;
+  float mCurrentET;
+  float mEndET;
+  int32_t mMaxLaps;
+  float mLapDist;
+  uint32_t mResultsStream;      // always 0
+  int32_t mNumVehicles;
+  // ScoringInfoV2
+  unsigned char mGamePhase;
+  signed char mYellowFlagState;
+  signed char mSectorFlag[3];
+  unsigned char mStartLight;
+  unsigned char mNumRedLights;
+  bool mInRealtime;
+  char mPlayerName[32];
+  char mPlrFileName[64];
+  float mDarkCloud;
+  float mRaining;
+  float mAmbientTemp;
+  float mTrackTemp;
+  TelemVect3 mWind;
+  float mOnPathWetness;
+  float mOffPathWetness;
+  unsigned char mExpansion[256];
+  uint32_t mVehicle;            // always 0
+};
+
+// sizes of the 32-bit sim's structs
+static_assert(sizeof(rfCaptureTelem) == 780, "rfCaptureTelem must match the 32-bit TelemInfoV2");
+static_assert(sizeof(rfCaptureVehicle) == 428, "rfCaptureVehicle must match the 32-bit VehicleScoringInfoV2");
+static_assert(sizeof(rfCaptureScoring) == 492, "rfCaptureScoring must match the 32-bit ScoringInfoV2");
+
+// copy the members first to last between a sim struct and its capture mirror,
+// which lay out that run of members alike (nothing wider than 4 bytes in it)
+#define RF_CAPTURE_COPY(dst, src, first, last) \
+	memcpy(&(dst).first, &(src).first, (const char*)&(src).last + sizeof((src).last) - (const char*)&(src).first)
+
+template <class D, class S>
+inline void rfCaptureCopyTelem(D &dst, const S &src) {
+	dst.mDeltaTime = src.mDeltaTime;
+	dst.mLapNumber = src.mLapNumber;
+	RF_CAPTURE_COPY(dst, src, mLapStartET, mLocalRotAccel);
+	dst.mGear = src.mGear;
+	RF_CAPTURE_COPY(dst, src, mEngineRPM, mSteeringArmForce);
+	RF_CAPTURE_COPY(dst, src, mFuel, mWheel);
+}
+
+template <class D, class S>
+inline void rfCaptureCopyVehicle(D &dst, const S &src) {
+	RF_CAPTURE_COPY(dst, src, mDriverName, mNumPenalties);
+	RF_CAPTURE_COPY(dst, src, mIsPlayer, mTimeBehindNext);
+	dst.mLapsBehindNext = src.mLapsBehindNext;
+	dst.mTimeBehindLeader = src.mTimeBehindLeader;
+	dst.mLapsBehindLeader = src.mLapsBehindLeader;
+	RF_CAPTURE_COPY(dst, src, mLapStartET, mExpansion);
+}
+
+template <class D, class S>
+inline void rfCaptureCopyScoring(D &dst, const S &src) {
+	memcpy(dst.mTrackName, src.mTrackName, sizeof(dst.mTrackName));
+	dst.mSession = src.mSession;
+	dst.mCurrentET = src.mCurrentET;
+	dst.mEndET = src.mEndET;
+	dst.mMaxLaps = src.mMaxLaps;
+	dst.mLapDist = src.mLapDist;
+	dst.mNumVehicles = src.mNumVehicles;
+	RF_CAPTURE_COPY(dst, src, mGamePhase, mExpansion);
+}
+
+inline void rfCaptureFromTelem(const TelemInfoV2 &info, rfCaptureTelem &out) {
+	rfCaptureCopyTelem(out, info);
+}
+
+inline void rfCaptureToTelem(const rfCaptureTelem &capture, TelemInfoV2 &out) {
+	memset(&out, 0, sizeof(out));
+	rfCaptureCopyTelem(out, capture);
+}
+
+inline void rfCaptureFromVehicle(const VehicleScoringInfoV2 &info, rfCaptureVehicle &out) {
+	rfCaptureCopyVehicle(out, info);
+}
+
+inline void rfCaptureToVehicle(const rfCaptureVehicle &capture, VehicleScoringInfoV2 &out) {
+	memset(&out, 0, sizeof(out));
+	rfCaptureCopyVehicle(out, capture);
+}
+
+// the vehicles are translated separately
+inline void rfCaptureFromScoring(const ScoringInfoV2 &info, rfCaptureScoring &out) {
+	rfCaptureCopyScoring(out, info);
+	out.mResultsStream = 0;
+	out.mVehicle = 0;
+}
+
+// mVehicle and mResultsStream are left NULL for the caller to point somewhere
+inline void rfCaptureToScoring(const rfCaptureScoring &capture, ScoringInfoV2 &out) {
+	memset(&out, 0, sizeof(out));
+	rfCaptureCopyScoring(out, capture);
+}
+
+// header describing captures made by this build
+inline rfCaptureHeader rfCaptureMakeHeader() {
+	rfCaptureHeader header = { RF_CAPTURE_MAGIC, RF_CAPTURE_VERSION,
+		sizeof(rfCaptureTelem), sizeof(rfCaptureScoring), sizeof(rfCaptureVehicle) };
+	return header;
+}
+
+// whether a capture with this header can be read by this build
+inline bool rfCaptureCompatible(const rfCaptureHeader &header) {
+	rfCaptureHeader ours = rfCaptureMakeHeader();
+	return header.magic == ours.magic && header.version == ours.version &&
+		header.telemSize == ours.telemSize && header.scoringSize == ours.scoringSize &&
+		header.vehicleSize == ours.vehicleSize;
+}
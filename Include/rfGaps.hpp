@@ -0,0 +1,56 @@
+/*
+rfGaps.hpp
+by Dan Allongo (daniel.s.allongo@gmail.com)
+
+Relative gaps between the vehicles on track, kept up to date at the telemetry
+rate from the interpolated lapDist and speed rather than waiting for the
+timeBehindNext of the next scoring update.
+
+The vehicles are kept sorted by where they are around the lap; from one tick
+to the next only the odd overtake moves anything, so an insertion sort keeps
+the order in about one comparison per vehicle. Each vehicle also stamps the
+session time at which it passes each of RF_GAPS_MARKS marks around the lap,
+so the time gap to the vehicle ahead is how long ago it was where this one is
+now. That follows braking and traction zones the way a timing loop would,
+where distance over speed doesn't. Until the vehicle ahead has been seen
+passing here, the gap falls back to distance over speed.
+*/
+
+#pragma once
+
+#include "rfSharedStruct.hpp"
+
+#define RF_GAPS_MARKS 512             // marks around the lap each vehicle's passing times are kept at
+#define RF_GAPS_MAX_STEP 1.0f         // seconds between updates (or back in time) past which the passing times are dropped
+
+class rfGapEngine {
+ public:
+  rfGapEngine();
+
+  // forget every passing time, e.g. between sessions
+  void Reset();
+  // order the first count vehicles around a lap of length and update their gaps at session time et
+  void Update(const float *lapDist, const float *speed, int count, float length, float et);
+
+  // published in rfVehicleInfo
+  float distanceAhead[RF_SHARED_MEMORY_MAX_VEHICLES];
+  float timeAhead[RF_SHARED_MEMORY_MAX_VEHICLES];
+  float distanceBehind[RF_SHARED_MEMORY_MAX_VEHICLES];
+  float timeBehind[RF_SHARED_MEMORY_MAX_VEHICLES];
+  signed char ahead[RF_SHARED_MEMORY_MAX_VEHICLES];
+  signed char behind[RF_SHARED_MEMORY_MAX_VEHICLES];
+
+ private:
+  void Stamp(int v, float from, float to, float t0, float t1);
+  float PassTime(int v, float d, float et) const;
+
+  int count;
+  float length;
+  float spacing;                // meters between marks
+  float perMark;                // 1 / spacing
+  float lastET;
+  float validFrom;              // passing times before this are stale
+  float dist[RF_SHARED_MEMORY_MAX_VEHICLES];          // lapDist wrapped into [0, length)
+  unsigned char order[RF_SHARED_MEMORY_MAX_VEHICLES]; // vehicles by increasing dist
+  float passed[RF_SHARED_MEMORY_MAX_VEHICLES][RF_GAPS_MARKS]; // session time each vehicle last passed each mark, -1 if not seen
+};
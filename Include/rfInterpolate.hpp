@@ -0,0 +1,41 @@
+/*
+rfInterpolate.hpp
+by Dan Allongo (daniel.s.allongo@gmail.com)
+
+Vehicle interpolation between scoring updates. The cached scoring state is
+kept as structure-of-arrays so the kernels can work on 1, 4 (SSE) or 8 (AVX)
+vehicles at a time; rfSelectInterpolate picks the widest one the CPU supports.
+*/
+
+#pragma once
+
+#include "rfSharedStruct.hpp"
+
+#define RF_INTERPOLATE_MAX_LANES 8   // RF_SHARED_MEMORY_MAX_VEHICLES must be a multiple of this
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define RF_INTERPOLATE_X86 1
+#endif
+
+// interpolated values published in rfVehicleInfo
+struct rfVehicleInterpSoA {
+  rfVec3SoA pos;
+  float yaw[RF_SHARED_MEMORY_MAX_VEHICLES];
+  float pitch[RF_SHARED_MEMORY_MAX_VEHICLES];
+  float roll[RF_SHARED_MEMORY_MAX_VEHICLES];
+  float speed[RF_SHARED_MEMORY_MAX_VEHICLES];
+  float lapDist[RF_SHARED_MEMORY_MAX_VEHICLES];
+};
+
+// extrapolate the first count vehicles of in by dt seconds into out
+// kernels may compute up to RF_INTERPOLATE_MAX_LANES - 1 vehicles past count
+typedef void (*rfInterpolateFunc)(const rfVehicleStateSoA &in, int count, float dt, rfVehicleInterpSoA &out);
+
+void rfInterpolateScalar(const rfVehicleStateSoA &in, int count, float dt, rfVehicleInterpSoA &out);
+#ifdef RF_INTERPOLATE_X86
+void rfInterpolateSSE(const rfVehicleStateSoA &in, int count, float dt, rfVehicleInterpSoA &out);
+void rfInterpolateAVX(const rfVehicleStateSoA &in, int count, float dt, rfVehicleInterpSoA &out);
+#endif
+
+// widest kernel supported by this CPU
+rfInterpolateFunc rfSelectInterpolate();
@@ -0,0 +1,229 @@
+/*
+rfInterpolateKernel.hpp
+by Dan Allongo (daniel.s.allongo@gmail.com)
+
+The interpolation kernel, written once against a small lane type so the same
+math runs on plain floats, SSE and AVX. Only included by the rfInterpolate*.cpp
+files, each of which is built with the instruction set its lane type needs.
+
+sin/cos and atan2 are Cephes-style polynomial approximations (~1e-7 relative
+error) so every lane width produces the same results.
+*/
+
+#pragma once
+
+#include "rfInterpolate.hpp"
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RF_LANE_SSE 1
+#endif
+#if defined(__AVX__)
+#include <immintrin.h>
+#define RF_LANE_AVX 1
+#endif
+
+// one vehicle at a time
+struct rfMask1 { bool m; };
+struct rfFloat1 {
+  float v;
+  enum { width = 1 };
+  static rfFloat1 load(const float *p) { rfFloat1 r = { *p }; return r; }
+  static rfFloat1 set(float f) { rfFloat1 r = { f }; return r; }
+  void store(float *p) const { *p = v; }
+};
+inline rfFloat1 operator+(const rfFloat1 &a, const rfFloat1 &b) { rfFloat1 r = { a.v + b.v }; return r; }
+inline rfFloat1 operator-(const rfFloat1 &a, const rfFloat1 &b) { rfFloat1 r = { a.v - b.v }; return r; }
+inline rfFloat1 operator*(const rfFloat1 &a, const rfFloat1 &b) { rfFloat1 r = { a.v * b.v }; return r; }
+inline rfFloat1 operator/(const rfFloat1 &a, const rfFloat1 &b) { rfFloat1 r = { a.v / b.v }; return r; }
+inline rfMask1 operator>(const rfFloat1 &a, const rfFloat1 &b) { rfMask1 r = { a.v > b.v }; return r; }
+inline rfMask1 operator<(const rfFloat1 &a, const rfFloat1 &b) { rfMask1 r = { a.v < b.v }; return r; }
+inline rfMask1 operator==(const rfFloat1 &a, const rfFloat1 &b) { rfMask1 r = { a.v == b.v }; return r; }
+inline rfMask1 operator|(const rfMask1 &a, const rfMask1 &b) { rfMask1 r = { a.m || b.m }; return r; }
+inline rfFloat1 rfSelect(const rfMask1 &m, const rfFloat1 &a, const rfFloat1 &b) { return m.m ? a : b; }
+inline rfFloat1 rfSqrt(const rfFloat1 &a) { rfFloat1 r = { sqrtf(a.v) }; return r; }
+inline rfFloat1 rfAbs(const rfFloat1 &a) { rfFloat1 r = { fabsf(a.v) }; return r; }
+inline rfFloat1 rfMin(const rfFloat1 &a, const rfFloat1 &b) { return a.v < b.v ? a : b; }
+inline rfFloat1 rfMax(const rfFloat1 &a, const rfFloat1 &b) { return a.v > b.v ? a : b; }
+inline rfFloat1 rfTrunc(const rfFloat1 &a) { rfFloat1 r = { (float)(int)a.v }; return r; }
+
+#ifdef RF_LANE_SSE
+// four vehicles at a time
+struct rfMask4 { __m128 m; };
+struct rfFloat4 {
+  __m128 v;
+  enum { width = 4 };
+  static rfFloat4 load(const float *p) { rfFloat4 r = { _mm_loadu_ps(p) }; return r; }
+  static rfFloat4 set(float f) { rfFloat4 r = { _mm_set1_ps(f) }; return r; }
+  void store(float *p) const { _mm_storeu_ps(p, v); }
+};
+inline rfFloat4 operator+(const rfFloat4 &a, const rfFloat4 &b) { rfFloat4 r = { _mm_add_ps(a.v, b.v) }; return r; }
+inline rfFloat4 operator-(const rfFloat4 &a, const rfFloat4 &b) { rfFloat4 r = { _mm_sub_ps(a.v, b.v) }; return r; }
+inline rfFloat4 operator*(const rfFloat4 &a, const rfFloat4 &b) { rfFloat4 r = { _mm_mul_ps(a.v, b.v) }; return r; }
+inline rfFloat4 operator/(const rfFloat4 &a, const rfFloat4 &b) { rfFloat4 r = { _mm_div_ps(a.v, b.v) }; return r; }
+inline rfMask4 operator>(const rfFloat4 &a, const rfFloat4 &b) { rfMask4 r = { _mm_cmpgt_ps(a.v, b.v) }; return r; }
+inline rfMask4 operator<(const rfFloat4 &a, const rfFloat4 &b) { rfMask4 r = { _mm_cmplt_ps(a.v, b.v) }; return r; }
+inline rfMask4 operator==(const rfFloat4 &a, const rfFloat4 &b) { rfMask4 r = { _mm_cmpeq_ps(a.v, b.v) }; return r; }
+inline rfMask4 operator|(const rfMask4 &a, const rfMask4 &b) { rfMask4 r = { _mm_or_ps(a.m, b.m) }; return r; }
+inline rfFloat4 rfSelect(const rfMask4 &m, const rfFloat4 &a, const rfFloat4 &b) {
+	rfFloat4 r = { _mm_or_ps(_mm_and_ps(m.m, a.v), _mm_andnot_ps(m.m, b.v)) };
+	return r;
+}
+inline rfFloat4 rfSqrt(const rfFloat4 &a) { rfFloat4 r = { _mm_sqrt_ps(a.v) }; return r; }
+inline rfFloat4 rfAbs(const rfFloat4 &a) { rfFloat4 r = { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; return r; }
+inline rfFloat4 rfMin(const rfFloat4 &a, const rfFloat4 &b) { rfFloat4 r = { _mm_min_ps(a.v, b.v) }; return r; }
+inline rfFloat4 rfMax(const rfFloat4 &a, const rfFloat4 &b) { rfFloat4 r = { _mm_max_ps(a.v, b.v) }; return r; }
+inline rfFloat4 rfTrunc(const rfFloat4 &a) { rfFloat4 r = { _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v)) }; return r; }
+#endif
+
+#ifdef RF_LANE_AVX
+// eight vehicles at a time
+struct rfMask8 { __m256 m; };
+struct rfFloat8 {
+  __m256 v;
+  enum { width = 8 };
+  static rfFloat8 load(const float *p) { rfFloat8 r = { _mm256_loadu_ps(p) }; return r; }
+  static rfFloat8 set(float f) { rfFloat8 r = { _mm256_set1_ps(f) }; return r; }
+  void store(float *p) const { _mm256_storeu_ps(p, v); }
+};
+inline rfFloat8 operator+(const rfFloat8 &a, const rfFloat8 &b) { rfFloat8 r = { _mm256_add_ps(a.v, b.v) }; return r; }
+inline rfFloat8 operator-(const rfFloat8 &a, const rfFloat8 &b) { rfFloat8 r = { _mm256_sub_ps(a.v, b.v) }; return r; }
+inline rfFloat8 operator*(const rfFloat8 &a, const rfFloat8 &b) { rfFloat8 r = { _mm256_mul_ps(a.v, b.v) }; return r; }
+inline rfFloat8 operator/(const rfFloat8 &a, const rfFloat8 &b) { rfFloat8 r = { _mm256_div_ps(a.v, b.v) }; return r; }
+inline rfMask8 operator>(const rfFloat8 &a, const rfFloat8 &b) { rfMask8 r = { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; return r; }
+inline rfMask8 operator<(const rfFloat8 &a, const rfFloat8 &b) { rfMask8 r = { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; return r; }
+inline rfMask8 operator==(const rfFloat8 &a, const rfFloat8 &b) { rfMask8 r = { _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ) }; return r; }
+inline rfMask8 operator|(const rfMask8 &a, const rfMask8 &b) { rfMask8 r = { _mm256_or_ps(a.m, b.m) }; return r; }
+inline rfFloat8 rfSelect(const rfMask8 &m, const rfFloat8 &a, const rfFloat8 &b) { rfFloat8 r = { _mm256_blendv_ps(b.v, a.v, m.m) }; return r; }
+inline rfFloat8 rfSqrt(const rfFloat8 &a) { rfFloat8 r = { _mm256_sqrt_ps(a.v) }; return r; }
+inline rfFloat8 rfAbs(const rfFloat8 &a) { rfFloat8 r = { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v) }; return r; }
+inline rfFloat8 rfMin(const rfFloat8 &a, const rfFloat8 &b) { rfFloat8 r = { _mm256_min_ps(a.v, b.v) }; return r; }
+inline rfFloat8 rfMax(const rfFloat8 &a, const rfFloat8 &b) { rfFloat8 r = { _mm256_max_ps(a.v, b.v) }; return r; }
+inline rfFloat8 rfTrunc(const rfFloat8 &a) { rfFloat8 r = { _mm256_round_ps(a.v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC) }; return r; }
+#endif
+
+template <class V>
+inline void rfSinCos(const V &x, V &s, V &c) {
+	const V zero = V::set(0.0f);
+	const V one = V::set(1.0f);
+	const V negOne = V::set(-1.0f);
+	V ax = rfAbs(x);
+	// octant of |x|, rounded up to even so the remainder lies in [-pi/4, pi/4]
+	V j = rfTrunc(ax * V::set(1.27323954473516f));
+	j = rfTrunc((j + one) * V::set(0.5f)) * V::set(2.0f);
+	V q = j - rfTrunc(j * V::set(0.125f)) * V::set(8.0f);
+	V r = ((ax - j * V::set(0.78515625f)) - j * V::set(2.4187564849853515625e-4f)) - j * V::set(3.77489497744594108e-8f);
+	V z = r * r;
+	V sinPoly = ((V::set(-1.9515295891e-4f) * z + V::set(8.3321608736e-3f)) * z - V::set(1.6666654611e-1f)) * z * r + r;
+	V cosPoly = ((V::set(2.443315711809948e-5f) * z - V::set(1.388731625493765e-3f)) * z + V::set(4.166664568298827e-2f)) * z * z
+		- V::set(0.5f) * z + one;
+	V two = V::set(2.0f);
+	V four = V::set(4.0f);
+	V six = V::set(6.0f);
+	// octants 2 and 6 swap the polynomials, 4 and 6 flip the sign of sin
+	auto swap = (q == two) | (q == six);
+	V sinSign = rfSelect(q > V::set(3.0f), negOne, one);
+	sinSign = rfSelect(x < zero, zero - sinSign, sinSign);
+	V cosSign = rfSelect((q == two) | (q == four), negOne, one);
+	s = rfSelect(swap, cosPoly, sinPoly) * sinSign;
+	c = rfSelect(swap, sinPoly, cosPoly) * cosSign;
+}
+
+template <class V>
+inline V rfAtan2(const V &y, const V &x) {
+	const V zero = V::set(0.0f);
+	const V one = V::set(1.0f);
+	V ay = rfAbs(y);
+	V ax = rfAbs(x);
+	V hi = rfMax(ax, ay);
+	V lo = rfMin(ax, ay);
+	// atan of a ratio in [0, 1], reduced around tan(pi/8)
+	V t = rfSelect(hi > zero, lo / hi, zero);
+	auto reduce = t > V::set(0.4142135623730950f);
+	V base = rfSelect(reduce, V::set(0.785398163397448f), zero);
+	t = rfSelect(reduce, (t - one) / (t + one), t);
+	V z = t * t;
+	V a = (((V::set(8.05374449538e-2f) * z - V::set(1.38776856032e-1f)) * z + V::set(1.99777106478e-1f)) * z
+		- V::set(3.33329491539e-1f)) * z * t + t + base;
+	// back out to the full circle
+	a = rfSelect(ay > ax, V::set(1.57079632679490f) - a, a);
+	a = rfSelect(x < zero, V::set(3.14159265358979f) - a, a);
+	return rfSelect(y < zero, zero - a, a);
+}
+
+// rotation matrix for the rotation vector (rx, ry, rz) by Rodrigues' formula
+// R = I + a*W + b*W^2 with W the cross-product matrix, a = sin(t)/t, b = (1-cos(t))/t^2
+template <class V>
+inline void rfRodrigues(const V &rx, const V &ry, const V &rz, V m[9]) {
+	const V one = V::set(1.0f);
+	V t2 = rx * rx + ry * ry + rz * rz;
+	V t = rfSqrt(t2);
+	V s, c;
+	rfSinCos(t, s, c);
+	// fall back to the series expansion where dividing by t loses precision
+	auto small = t2 < V::set(1e-6f);
+	V a = rfSelect(small, one - t2 * V::set(1.0f / 6.0f), s / t);
+	V b = rfSelect(small, V::set(0.5f) - t2 * V::set(1.0f / 24.0f), (one - c) / t2);
+	// W^2 = r*r^T - t^2*I
+	V d = one - b * t2;
+	V bxy = b * rx * ry, bxz = b * rx * rz, byz = b * ry * rz;
+	m[0] = d + b * rx * rx; m[1] = bxy - a * rz;        m[2] = bxz + a * ry;
+	m[3] = bxy + a * rz;    m[4] = d + b * ry * ry;     m[5] = byz - a * rx;
+	m[6] = bxz - a * ry;    m[7] = byz + a * rx;        m[8] = d + b * rz * rz;
+}
+
+template <class V>
+inline void rfRotate(const V m[9], V &vx, V &vy, V &vz) {
+	V x = m[0] * vx + m[1] * vy + m[2] * vz;
+	V y = m[3] * vx + m[4] * vy + m[5] * vz;
+	V z = m[6] * vx + m[7] * vy + m[8] * vz;
+	vx = x;
+	vy = y;
+	vz = z;
+}
+
+template <class V>
+void rfInterpolateKernel(const rfVehicleStateSoA &in, int count, float delta, rfVehicleInterpSoA &out) {
+	const V dt = V::set(delta);
+	const V accStep = V::set(delta * RF_SHARED_MEMORY_ACC_SMOOTH_FACTOR);
+	const V rotStep = V::set(delta * RF_SHARED_MEMORY_ROT_SMOOTH_FACTOR);
+	for (int i = 0; i < count; i += V::width) {
+		// applying a fraction of the acceleration seems to help the interpolation
+		V rotX = V::load(&in.localRot.x[i]) + V::load(&in.localRotAccel.x[i]) * accStep;
+		V rotY = V::load(&in.localRot.y[i]) + V::load(&in.localRotAccel.y[i]) * accStep;
+		V rotZ = V::load(&in.localRot.z[i]) + V::load(&in.localRotAccel.z[i]) * accStep;
+		V velX = V::load(&in.localVel.x[i]) + V::load(&in.localAccel.x[i]) * accStep;
+		V velY = V::load(&in.localVel.y[i]) + V::load(&in.localAccel.y[i]) * accStep;
+		V velZ = V::load(&in.localVel.z[i]) + V::load(&in.localAccel.z[i]) * accStep;
+
+		V xx = V::load(&in.oriX.x[i]), xy = V::load(&in.oriX.y[i]), xz = V::load(&in.oriX.z[i]);
+		V yx = V::load(&in.oriY.x[i]), yy = V::load(&in.oriY.y[i]), yz = V::load(&in.oriY.z[i]);
+		V zx = V::load(&in.oriZ.x[i]), zy = V::load(&in.oriZ.y[i]), zz = V::load(&in.oriZ.z[i]);
+
+		// world rotation over dt as one matrix; the orientation rows are turned the
+		// opposite way, matching the old per-axis z/y/x rotations to first order
+		V zero = V::set(0.0f);
+		V m[9];
+		rfRodrigues(zero - (xx * rotX + xy * rotY + xz * rotZ) * rotStep,
+			zero - (yx * rotX + yy * rotY + yz * rotZ) * rotStep,
+			zero - (zx * rotX + zy * rotY + zz * rotZ) * rotStep, m);
+
+		// a proper rotation keeps the rows orthonormal, no renormalizing needed
+		rfRotate(m, xx, xy, xz);
+		rfRotate(m, yx, yy, yz);
+		rfRotate(m, zx, zy, zz);
+
+		// position
+		(V::load(&in.pos.x[i]) + (xx * velX + xy * velY + xz * velZ) * dt).store(&out.pos.x[i]);
+		(V::load(&in.pos.y[i]) + (yx * velX + yy * velY + yz * velZ) * dt).store(&out.pos.y[i]);
+		(V::load(&in.pos.z[i]) + (zx * velX + zy * velY + zz * velZ) * dt).store(&out.pos.z[i]);
+
+		rfAtan2(zx, zz).store(&out.yaw[i]);
+		rfAtan2(zero - yz, rfSqrt(xz * xz + zz * zz)).store(&out.pitch[i]);
+		rfAtan2(yx, rfSqrt(xx * xx + zx * zx)).store(&out.roll[i]);
+
+		rfSqrt(velX * velX + velY * velY + velZ * velZ).store(&out.speed[i]);
+		(V::load(&in.lapDist[i]) - velZ * dt).store(&out.lapDist[i]);
+	}
+}
@@ -0,0 +1,178 @@
+/*
+rfPlatform.hpp
+by Dan Allongo (daniel.s.allongo@gmail.com)
+
+The few OS services the plugin needs, so the core builds on both Windows
+(rfPlatformWin32.cpp) and Linux (rfPlatformPosix.cpp). Only one of the two
+implementations is compiled into any given build.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#elif defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+#ifdef _WIN32
+#define RF_PLUGIN_EXPORT extern "C" __declspec(dllexport)
+#else
+#define RF_PLUGIN_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+// a named shared memory segment
+struct rfMapping {
+  void *view;                   // mapped view, NULL when not mapped
+  size_t size;                  // size of the view in bytes
+  intptr_t handle;              // HANDLE on Windows, file descriptor on POSIX
+  char name[256];               // name the segment was created under
+  bool owner;                   // whether this process created the segment
+};
+
+// create the named segment (or open it if a reader got there first) and map it
+// returns the mapped view, or NULL with map left closed on failure
+void* rfMapCreate(rfMapping &map, const char *name, size_t size);
+
+// unmap the view and release the segment (removing it if we created it)
+void rfMapClose(rfMapping &map);
+
+// build the segment name for this process into tag
+// dedicated servers get their process id appended to allow multiple instances
+void rfMapName(char *tag, size_t len, const char *name);
+
+// a file written through a window mapped into memory, see rfFileMapWindow
+struct rfFile {
+  intptr_t handle;              // HANDLE on Windows, file descriptor on POSIX
+  intptr_t mapHandle;           // file mapping HANDLE on Windows, unused on POSIX
+  void *view;                   // currently mapped window, NULL if none
+  unsigned long long offset;    // file offset of the window
+  size_t size;                  // size of the window in bytes
+};
+
+// create a new file at path for writing; fails if the file already exists
+bool rfFileCreate(rfFile &file, const char *path);
+
+// grow the file to cover offset + size bytes if needed and map that window in
+// place of the previous one; offset must be a multiple of 64 KB
+// returns the window, or NULL on failure (e.g. disk full)
+void* rfFileMapWindow(rfFile &file, unsigned long long offset, size_t size);
+
+// unmap the window, trim the file to length bytes and close it
+void rfFileClose(rfFile &file, unsigned long long length);
+
+// a wakeup readers can block on instead of polling: a counter word in shared
+// memory that the writer bumps after each publication, backed by a named
+// semaphore (Win32) or a futex on the counter itself (POSIX) so the writer only
+// pays for a system call when somebody is actually waiting
+struct rfSignal {
+  volatile uint32_t *counter;   // bumped by rfSignalNotify
+  volatile uint32_t *waiters;   // readers blocked (or about to block) in rfSignalWait
+  intptr_t handle;              // semaphore HANDLE on Windows, unused on POSIX
+};
+
+// attach to the signal called name, whose words live in memory shared by every user
+bool rfSignalOpen(rfSignal &signal, const char *name, volatile uint32_t *counter, volatile uint32_t *waiters);
+void rfSignalClose(rfSignal &signal);
+
+// writer side: bump the counter and wake everybody waiting
+void rfSignalNotify(rfSignal &signal);
+
+// reader side: block until the counter differs from last, or timeout seconds
+// pass (wait forever if negative); returns whether the counter moved
+// may return early, so callers should loop on the counter
+bool rfSignalWait(rfSignal &signal, uint32_t last, double timeout);
+
+// seek a stdio stream to a 64-bit offset (recordings outgrow long on Windows)
+inline bool rfSeek(FILE *f, unsigned long long offset) {
+#ifdef _WIN32
+	return _fseeki64(f, (long long)offset, SEEK_SET) == 0;
+#else
+	return fseeko(f, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+inline unsigned long long rfTell(FILE *f) {
+#ifdef _WIN32
+	return (unsigned long long)_ftelli64(f);
+#else
+	return (unsigned long long)ftello(f);
+#endif
+}
+
+// seconds on a monotonic high-resolution clock shared by all processes
+// (QueryPerformanceCounter on Windows, CLOCK_MONOTONIC on POSIX)
+double rfClockSeconds();
+
+// cheap timestamp for instrumentation: the TSC on x86, nanoseconds elsewhere
+// the rate is calibrated against rfClockSeconds by whoever needs seconds
+inline unsigned long long rfCycles() {
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+	return __rdtsc();
+#else
+	return (unsigned long long)(rfClockSeconds() * 1e9);
+#endif
+}
+
+// index of the highest set bit, 0 for 0 and 1
+inline int rfLog2(unsigned long long x) {
+#ifdef _MSC_VER
+	unsigned long bit;
+	if (_BitScanReverse(&bit, (unsigned long)(x >> 32))) {
+		return (int)bit + 32;
+	}
+	return _BitScanReverse(&bit, (unsigned long)x) ? (int)bit : 0;
+#else
+	return x ? 63 - __builtin_clzll(x) : 0;
+#endif
+}
+
+// whether the CPU and OS support AVX (used to pick the interpolation kernel)
+bool rfCpuHasAVX();
+
+// id of the calling process
+uint32_t rfProcessId();
+
+// one line of diagnostics for failures nobody would otherwise see
+// (OutputDebugString on Windows, stderr elsewhere)
+void rfLog(const char *format, ...);
+
+// atomic read-modify-write on words shared with other processes
+inline uint32_t rfAtomicOr(volatile uint32_t *p, uint32_t bits) {
+#ifdef _MSC_VER
+	return (uint32_t)_InterlockedOr((volatile long*)p, (long)bits);
+#else
+	return __atomic_fetch_or(p, bits, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// store desired if *p is expected; returns the value *p held before
+inline uint32_t rfAtomicCompareExchange(volatile uint32_t *p, uint32_t expected, uint32_t desired) {
+#ifdef _MSC_VER
+	return (uint32_t)_InterlockedCompareExchange((volatile long*)p, (long)desired, (long)expected);
+#else
+	__atomic_compare_exchange_n(p, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return expected;
+#endif
+}
+
+// returns the value before the add
+inline uint32_t rfAtomicAdd(volatile uint32_t *p, uint32_t value) {
+#ifdef _MSC_VER
+	return (uint32_t)_InterlockedExchangeAdd((volatile long*)p, (long)value);
+#else
+	return __atomic_fetch_add(p, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+inline uint32_t rfAtomicExchange(volatile uint32_t *p, uint32_t value) {
+#ifdef _MSC_VER
+	return (uint32_t)_InterlockedExchange((volatile long*)p, (long)value);
+#else
+	return __atomic_exchange_n(p, value, __ATOMIC_SEQ_CST);
+#endif
+}
@@ -0,0 +1,20 @@
+/*
+rfPlatformHeap.hpp
+by Dan Allongo (daniel.s.allongo@gmail.com)
+
+rfPlatformHeap.cpp implements rfPlatform.hpp with plain heap allocations
+instead of shared memory, for benchmarks that want to measure the plugin
+without the OS mapping underneath. Link it in place of the real backend.
+Mapping the same name twice returns the same block, so an in-process
+"reader" still sees what the plugin writes.
+*/
+
+#pragma once
+
+#include <stddef.h>
+
+// number of blocks currently mapped
+int rfHeapMapCount();
+
+// view and size of the i-th mapped block (0 <= i < rfHeapMapCount())
+void* rfHeapMapView(int i, size_t &size);
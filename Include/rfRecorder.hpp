@@ -0,0 +1,67 @@
+/*
+rfRecorder.hpp
+by Dan Allongo (daniel.s.allongo@gmail.com)
+
+Records plugin callbacks to disk in the rfCapture.hpp format without letting
+disk I/O anywhere near the sim's thread. Record() only copies the payload into
+a lock-free single-producer/single-consumer byte queue; a background thread
+drains the queue into the file through a memory-mapped window that moves
+along as the file grows, so the address space needed stays constant however
+long the session runs.
+
+If the writer can't keep up and the queue fills, records are dropped (and
+counted) rather than stalling the caller.
+*/
+
+#pragma once
+
+#include "rfCapture.hpp"
+#include "rfPlatform.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#define RF_RECORDER_QUEUE_SIZE (16 << 20)   // bytes, must be a power of two
+#define RF_RECORDER_WINDOW_SIZE (16 << 20)  // bytes of the file mapped at a time, a multiple of 64 KB
+
+class rfRecorder {
+ public:
+  rfRecorder();
+  ~rfRecorder();
+
+  bool Start(const char *path);   // create the capture file and start the writer thread
+  void Stop();                    // write out everything queued, trim the file and stop the writer
+  bool Recording() const { return recording; }
+
+  // queue one record; the payload is the concatenation of payload and extra
+  // only ever called from one thread (the sim's)
+  void Record(rfCaptureType type, const void *payload = NULL, size_t size = 0, const void *extra = NULL, size_t extraSize = 0);
+  // translate a sim callback into its rfCapture.hpp payload and queue it
+  void RecordTelemetry(const TelemInfoV2 &info);
+  void RecordScoring(const ScoringInfoV2 &info);
+
+  unsigned long long Records() const { return records; }    // records queued since Start
+  unsigned long long Dropped() const { return dropped; }    // records dropped because the queue was full
+  unsigned long long Written() const { return written.load(std::memory_order_relaxed); } // bytes in the file
+  bool Failed() const { return failed.load(std::memory_order_relaxed); } // the file couldn't be grown, later records are lost
+
+ private:
+  void Put(unsigned long long pos, const void *data, size_t size); // copy into the queue at pos, wrapping around
+  void Run();                     // writer thread
+
+  bool recording;
+  char *queue;
+  std::atomic<unsigned long long> head;   // bytes queued, advanced by Record
+  std::atomic<unsigned long long> tail;   // bytes taken off the queue by the writer
+  std::atomic<bool> stopping;
+  std::atomic<bool> failed;
+  std::atomic<unsigned long long> written;
+  unsigned long long records;
+  unsigned long long dropped;
+  double startTime;
+  rfFile file;
+  std::thread writer;
+  rfCaptureTelem telem;           // payloads being translated, on the sim's thread
+  rfCaptureScoring scoring;
+  std::vector<rfCaptureVehicle> vehicles;
+};
@@ -0,0 +1,16 @@
+/*
+rfSchema.hpp
+by Dan Allongo (daniel.s.allongo@gmail.com)
+
+Field descriptors for every struct the plugin publishes (see rfSchema in
+rfSharedStruct.hpp). The descriptors are built at compile time from the
+struct definitions with offsetof and decltype, so they can't drift from the
+layout; the plugin copies them into RF_SHARED_MEMORY_SCHEMA_NAME at Startup.
+*/
+
+#pragma once
+
+#include "rfSharedStruct.hpp"
+
+// fill the struct and field tables of schema (everything after reserved0)
+void rfSchemaFill(rfSchema &schema);
@@ -0,0 +1,402 @@
+/*
+rfSharedReader.hpp
+by Dan Allongo (daniel.s.allongo@gmail.com)
+
+Helpers for external programs reading the shared memory map.
+The snapshot helpers only depend on rfSharedStruct.hpp and the inline parts of
+rfPlatform.hpp. rfInterpolateScoringState, rfSharedOpenSignal and the reader
+registration helpers additionally need the interpolation kernels and platform
+layer linked in (librfSharedReader.a in the Linux build,
+or rfInterpolate*.cpp and rfPlatformWin32.cpp on Windows).
+*/
+
+#pragma once
+
+#include "rfSharedStruct.hpp"
+#include "rfPlatform.hpp"
+#include "rfInterpolate.hpp"
+#include <atomic>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// take a consistent copy of any struct published under a sequence lock,
+// retrying while the plugin is mid-update
+// returns false if no consistent copy could be taken within maxRetries attempts
+template <class T>
+inline bool rfSeqSnapshot(const T *src, T *dst, int maxRetries = 100) {
+	const volatile uint32_t *seq = &src->sequence;
+	for (int i = 0; i < maxRetries; i++) {
+		uint32_t before = *seq;
+		if (before & 1) {
+			continue;
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		memcpy(dst, src, sizeof(T));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (*seq == before) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// whether a struct published under a sequence lock may have changed since a
+// copy taken at lastSequence (the sequence of that copy), without copying it
+template <class T>
+inline bool rfSeqChanged(const T *src, uint32_t lastSequence) {
+	return *(const volatile uint32_t*)&src->sequence != lastSequence;
+}
+
+// take a consistent copy of the map
+inline bool rfSharedSnapshot(const rfShared *src, rfShared *dst, int maxRetries = 100) {
+	return rfSeqSnapshot(src, dst, maxRetries);
+}
+
+// extrapolate vehicles from a scoring state snapshot to time now (rfClockSeconds())
+// with the same kernel the plugin uses; entries past state.numVehicles are undefined
+inline void rfInterpolateScoringState(const rfScoringState &state, double now, rfVehicleInterpSoA &out) {
+	static const rfInterpolateFunc interpolate = rfSelectInterpolate();
+	float dt = (float)(now - state.scoringTime);
+	if (dt < 0.0f) {
+		dt = 0.0f;
+	} else if (dt > RF_SHARED_MEMORY_MAX_INTERPOLATION) {
+		dt = RF_SHARED_MEMORY_MAX_INTERPOLATION;
+	}
+	int count = state.numVehicles < RF_SHARED_MEMORY_MAX_VEHICLES ? (int)state.numVehicles : RF_SHARED_MEMORY_MAX_VEHICLES;
+	interpolate(state.vehicle, count, dt, out);
+}
+
+// ask the plugin for optional work (rfReaderFlag bits)
+// must be repeated at least every RF_SHARED_MEMORY_READER_TIMEOUT seconds, e.g. on every poll
+inline void rfSharedSubscribe(rfShared *map, uint32_t flags) {
+	rfAtomicOr(&map->readerFlags, flags);
+}
+
+// attach to the wakeup for telemetry (or, with scoring set, scoring) publications
+// on a mapped rfShared; instead of polling, remember the counter (telemetrySignal
+// or scoringSignal), take a snapshot and block in rfSignalWait until it moves
+inline bool rfSharedOpenSignal(rfSignal &signal, rfShared *map, bool scoring = false) {
+	char tag[256];
+	rfMapName(tag, sizeof(tag), scoring ? RF_SHARED_MEMORY_SCORING_SIGNAL_NAME : RF_SHARED_MEMORY_TELEMETRY_SIGNAL_NAME);
+	return scoring ? rfSignalOpen(signal, tag, &map->scoringSignal, &map->scoringWaiters) :
+		rfSignalOpen(signal, tag, &map->telemetrySignal, &map->telemetryWaiters);
+}
+
+// a slot in the reader table (rfReaderTable) held by this reader
+struct rfReaderRegistration {
+  rfReaderTable *table;
+  int slot;                     // -1 while not registered
+  uint32_t owner;               // token the slot was claimed with
+};
+
+// claim a free slot under name so the plugin tracks how far behind this reader is
+// returns false if every slot is taken
+inline bool rfReaderRegister(rfReaderRegistration &reg, rfReaderTable *table, const char *name) {
+	reg.table = table;
+	reg.slot = -1;
+	do {
+		reg.owner = rfAtomicAdd(&table->registrations, 1) + 1;
+	} while (reg.owner == 0);
+	for (int i = 0; i < RF_SHARED_MEMORY_MAX_READERS; i++) {
+		rfReaderSlot *slot = &table->slot[i];
+		if (*(volatile uint32_t*)&slot->owner != 0 || rfAtomicCompareExchange(&slot->owner, 0, reg.owner) != 0) {
+			continue;
+		}
+		slot->pid = rfProcessId();
+		strncpy(slot->name, name, sizeof(slot->name) - 1);
+		slot->name[sizeof(slot->name) - 1] = 0;
+		*(volatile uint32_t*)&slot->cursor = *(volatile uint32_t*)&table->head;
+		// the plugin only looks at the slot once the heartbeat is set
+		std::atomic_thread_fence(std::memory_order_release);
+		*(volatile double*)&slot->heartbeat = rfClockSeconds();
+		reg.slot = i;
+		return true;
+	}
+	return false;
+}
+
+// report the sequence of the last telemetry frame consumed: rfTelemetryFrame::sequence
+// for history and segment readers, or the table's head read just before a
+// snapshot of the main map; report at least every RF_SHARED_MEMORY_READER_STALE
+// seconds, even with nothing new, or the plugin frees the slot
+// returns false once the slot was lost, register again to carry on
+inline bool rfReaderConsume(rfReaderRegistration &reg, uint32_t cursor) {
+	if (reg.slot < 0) {
+		return false;
+	}
+	rfReaderSlot *slot = &reg.table->slot[reg.slot];
+	if (*(volatile uint32_t*)&slot->owner != reg.owner) {
+		reg.slot = -1;
+		return false;
+	}
+	*(volatile uint32_t*)&slot->cursor = cursor;
+	*(volatile double*)&slot->heartbeat = rfClockSeconds();
+	return true;
+}
+
+inline void rfReaderUnregister(rfReaderRegistration &reg) {
+	if (reg.slot < 0) {
+		return;
+	}
+	rfReaderSlot *slot = &reg.table->slot[reg.slot];
+	*(volatile double*)&slot->heartbeat = 0.0;
+	rfAtomicCompareExchange(&slot->owner, reg.owner, 0);
+	reg.slot = -1;
+}
+
+// copy up to maxFrames history frames newer than cursor into out, oldest first
+// cursor is the sequence of the last frame consumed (start at 0) and is advanced
+// past the frames returned; frames the writer has already overwritten are skipped
+inline int rfHistoryRead(const rfHistory *src, uint32_t &cursor, rfTelemetryFrame *out, int maxFrames) {
+	const volatile uint32_t *head = &src->head;
+	uint32_t newest = *head;
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (newest - cursor > RF_SHARED_MEMORY_HISTORY_SIZE) {
+		// fell behind by more than the ring holds
+		cursor = newest - RF_SHARED_MEMORY_HISTORY_SIZE;
+	}
+	int count = 0;
+	while (cursor != newest && count < maxFrames) {
+		uint32_t next = cursor + 1;
+		const rfTelemetryFrame *slot = &src->frame[(next - 1) & (RF_SHARED_MEMORY_HISTORY_SIZE - 1)];
+		const volatile uint32_t *seq = &slot->sequence;
+		cursor = next;
+		// same pattern as rfSeqSnapshot, except a slot that was overwritten or is
+		// being rewritten won't hold this frame again, so it is skipped rather than retried
+		if (*seq != next) {
+			continue;
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		memcpy(&out[count], slot, sizeof(rfTelemetryFrame));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (*seq != next) {
+			continue;
+		}
+		count++;
+	}
+	return count;
+}
+
+// latency in seconds below which a fraction p (0-1) of the calls in stats fell,
+// rounded up to the end of its histogram bucket; take a snapshot with rfSeqSnapshot first
+inline double rfStatsPercentile(const rfStats &stats, rfStatsProbe probe, double p) {
+	const rfLatencyStats &s = stats.probe[probe];
+	if (s.calls == 0 || stats.cyclesPerSecond <= 0.0) {
+		return 0.0;
+	}
+	unsigned long long target = (unsigned long long)(p * (double)s.calls + 0.5);
+	unsigned long long seen = 0;
+	for (int b = 0; b < RF_SHARED_MEMORY_STATS_BUCKETS - 1; b++) {
+		seen += s.bucket[b];
+		if (seen >= target) {
+			unsigned long long limit = 2ULL << b;
+			return (double)(limit < s.maxCycles ? limit : s.maxCycles) / stats.cyclesPerSecond;
+		}
+	}
+	return (double)s.maxCycles / stats.cyclesPerSecond;
+}
+
+// index of the struct called name in a schema snapshot, -1 if it isn't described
+inline int rfSchemaFindStruct(const rfSchema &schema, const char *name) {
+	for (uint32_t i = 0; i < schema.numStructs && i < RF_SHARED_MEMORY_SCHEMA_STRUCTS; i++) {
+		if (strncmp(schema.structs[i].name, name, sizeof(schema.structs[i].name)) == 0) {
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+// field of structs[index] called name (length bytes of it, all of it if -1), NULL if none
+inline const rfSchemaField* rfSchemaFindField(const rfSchema &schema, int index, const char *name, int length = -1) {
+	if (index < 0 || (uint32_t)index >= schema.numStructs || index >= RF_SHARED_MEMORY_SCHEMA_STRUCTS) {
+		return NULL;
+	}
+	size_t n = length < 0 ? strlen(name) : (size_t)length;
+	const rfSchemaStruct &s = schema.structs[index];
+	for (uint32_t i = s.firstField; i < (uint32_t)s.firstField + s.numFields && i < RF_SHARED_MEMORY_SCHEMA_FIELDS; i++) {
+		const rfSchemaField &f = schema.field[i];
+		if (n < sizeof(f.name) && strncmp(f.name, name, n) == 0 && f.name[n] == 0) {
+			return &f;
+		}
+	}
+	return NULL;
+}
+
+// byte offset of a member of the struct called structName, given as a path like
+// "speed", "wheel[2].temperature[1]" or "vehicle[5].pos[0]" (unindexed arrays
+// resolve to their first element); resolve once at attach time, then read the
+// mapped struct at that offset directly; -1 if the path doesn't resolve
+// field, if given, receives the descriptor of the last member on the path
+inline long rfSchemaResolve(const rfSchema &schema, const char *structName, const char *path, const rfSchemaField **field = NULL) {
+	int index = rfSchemaFindStruct(schema, structName);
+	long offset = 0;
+	const rfSchemaField *f = NULL;
+	const char *p = path;
+	for (;;) {
+		size_t n = strcspn(p, ".[");
+		f = rfSchemaFindField(schema, index, p, (int)n);
+		if (f == NULL) {
+			return -1;
+		}
+		offset += f->offset;
+		p += n;
+		if (*p == '[') {
+			char *end;
+			unsigned long element = strtoul(p + 1, &end, 10);
+			if (end == p + 1 || *end != ']' || element >= f->count) {
+				return -1;
+			}
+			offset += (long)(element * f->size);
+			p = end + 1;
+		}
+		if (*p == 0) {
+			break;
+		}
+		// only nested structs have members of their own
+		if (*p != '.' || f->type != schemaStruct) {
+			return -1;
+		}
+		index = f->ref;
+		p++;
+	}
+	if (field) {
+		*field = f;
+	}
+	return offset;
+}
+
+// text of an interned name id (e.g. rfVehicleInfo::driverNameId) in the mapped
+// RF_SHARED_MEMORY_STRINGS_NAME table, NULL if the table doesn't hold it (yet)
+// published strings never change while the plugin runs, so no snapshot is needed
+inline const char* rfStringLookup(const rfStringTable *table, uint32_t id) {
+	uint32_t count = *(volatile const uint32_t*)&table->numStrings;
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (id >= count || id >= RF_SHARED_MEMORY_MAX_STRINGS) {
+		return NULL;
+	}
+	return table->text[id];
+}
+
+// world position at lapDist on a copy of the learned track line, interpolated
+// between the two knots either side; heading, if given, receives the direction
+// of the line there (atan2(dx, dz)); false if either knot hasn't been learned yet
+inline bool rfTrackPosition(const rfTrackSegment &track, float lapDist, rfVec3 &pos, float *heading = NULL) {
+	if (track.numKnots == 0 || track.numKnots > RF_SHARED_MEMORY_MAX_KNOTS || track.spacing <= 0.0f) {
+		return false;
+	}
+	float d = fmodf(lapDist, track.length);
+	if (d < 0.0f) {
+		d += track.length;
+	}
+	float u = d / track.spacing;
+	uint32_t k0 = (uint32_t)u;
+	if (k0 >= track.numKnots) {
+		k0 = track.numKnots - 1;
+	}
+	float f = u - (float)k0;
+	const rfTrackKnot &a = track.knot[k0];
+	const rfTrackKnot &b = track.knot[k0 + 1 < track.numKnots ? k0 + 1 : 0];
+	if (a.weight <= 0.0f || b.weight <= 0.0f) {
+		return false;
+	}
+	pos.x = a.pos.x + (b.pos.x - a.pos.x) * f;
+	pos.y = a.pos.y + (b.pos.y - a.pos.y) * f;
+	pos.z = a.pos.z + (b.pos.z - a.pos.z) * f;
+	if (heading) {
+		*heading = atan2f(b.pos.x - a.pos.x, b.pos.z - a.pos.z);
+	}
+	return true;
+}
+
+// squared distance from pos to the learned knot k, -1 if it hasn't been learned
+inline float rfTrackKnotDistance(const rfTrackSegment &track, uint32_t k, const rfVec3 &pos) {
+	const rfTrackKnot &n = track.knot[k];
+	if (n.weight <= 0.0f) {
+		return -1.0f;
+	}
+	float dx = pos.x - n.pos.x, dy = pos.y - n.pos.y, dz = pos.z - n.pos.z;
+	return dx * dx + dy * dy + dz * dz;
+}
+
+// lapDist of the point on a copy of the learned track line closest to pos,
+// -1 if nothing has been learned; pass a lapDist the point was recently near
+// (e.g. the previous result) as hint to only search the knots around it,
+// otherwise every sqrt(n)th knot is checked, then the knots around every one
+// of those that could be a step from the nearest, so a leg of the track that
+// runs close by (a hairpin, a crossover) can't hide the right one
+inline float rfTrackDistance(const rfTrackSegment &track, const rfVec3 &pos, float hint = -1.0f) {
+	uint32_t n = track.numKnots;
+	if (n == 0 || n > RF_SHARED_MEMORY_MAX_KNOTS || track.spacing <= 0.0f) {
+		return -1.0f;
+	}
+	uint32_t step = (uint32_t)sqrtf((float)n);
+	if (step == 0) {
+		step = 1;
+	}
+	// knots to search around, at most one per coarse knot (sqrt(RF_SHARED_MEMORY_MAX_KNOTS) + 2)
+	int32_t candidate[64];
+	uint32_t numCandidates = 0;
+	if (hint >= 0.0f) {
+		candidate[numCandidates++] = (int32_t)(fmodf(hint, track.length) / track.spacing) % (int32_t)n;
+	} else {
+		float coarse[64];
+		float best = -1.0f;
+		for (uint32_t k = 0, c = 0; k < n; k += step, c++) {
+			coarse[c] = rfTrackKnotDistance(track, k, pos);
+			if (coarse[c] >= 0.0f && (best < 0.0f || coarse[c] < best)) {
+				best = coarse[c];
+			}
+		}
+		// the nearest knot is within half a step of some coarse knot, which can't be
+		// more than a step's length of line further from pos than the best one is
+		float radius = sqrtf(best) + step * track.spacing;
+		for (uint32_t k = 0, c = 0; k < n && best >= 0.0f; k += step, c++) {
+			if (coarse[c] >= 0.0f && coarse[c] <= radius * radius) {
+				candidate[numCandidates++] = (int32_t)k;
+			}
+		}
+	}
+	// nearest learned knot within a step of any candidate
+	int32_t nearest = -1;
+	float nearestDistance = -1.0f;
+	for (uint32_t c = 0; c < numCandidates; c++) {
+		for (int32_t o = -(int32_t)step; o <= (int32_t)step; o++) {
+			uint32_t k = (uint32_t)((candidate[c] + o + (int32_t)n) % (int32_t)n);
+			float d = rfTrackKnotDistance(track, k, pos);
+			if (d >= 0.0f && (nearestDistance < 0.0f || d < nearestDistance)) {
+				nearestDistance = d;
+				nearest = (int32_t)k;
+			}
+		}
+	}
+	if (nearest < 0) {
+		return -1.0f;
+	}
+	// project onto the line segments either side of it
+	float result = nearest * track.spacing;
+	float closest = nearestDistance;
+	for (int side = -1; side <= 1; side += 2) {
+		uint32_t k0 = side < 0 ? (uint32_t)(nearest + n - 1) % n : (uint32_t)nearest;
+		uint32_t k1 = (k0 + 1) % n;
+		const rfTrackKnot &a = track.knot[k0];
+		const rfTrackKnot &b = track.knot[k1];
+		if (a.weight <= 0.0f || b.weight <= 0.0f) {
+			continue;
+		}
+		float ex = b.pos.x - a.pos.x, ey = b.pos.y - a.pos.y, ez = b.pos.z - a.pos.z;
+		float len2 = ex * ex + ey * ey + ez * ez;
+		if (len2 <= 0.0f) {
+			continue;
+		}
+		float t = ((pos.x - a.pos.x) * ex + (pos.y - a.pos.y) * ey + (pos.z - a.pos.z) * ez) / len2;
+		t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+		float dx = pos.x - (a.pos.x + ex * t), dy = pos.y - (a.pos.y + ey * t), dz = pos.z - (a.pos.z + ez * t);
+		float d = dx * dx + dy * dy + dz * dz;
+		if (d < closest) {
+			closest = d;
+			result = (k0 + t) * track.spacing;
+		}
+	}
+	return result < track.length ? result : result - track.length;
+}
@@ -3,18 +3,115 @@ rfSharedStruct.hpp
 by Dan Allongo (daniel.s.allongo@gmail.com)
 
 This is the structure of the shared memory map
-It's nearly identical to the original structures specified in InternalsPlugin.hpp,
-but with pragma pack 1 specified to get the most compact representation.
-This means that you need to watch your types very closely!
+It's nearly identical to the original structures specified in InternalsPlugin.hpp.
+Since v4 every field is naturally aligned and only fixed-width integer types
+are used, so the layout is the same for 32 and 64-bit readers on Windows and
+Linux. Groups written at different rates are padded to 64-byte cache lines;
+the reserved fields are padding and always zero. The static_asserts at the
+end pin the layout, so any change to it has to be deliberate.
+
+The plugin publishes with a sequence lock: sequence is odd while an update
+is being written and even once the frame is consistent. Readers should copy
+the struct and retry if sequence was odd or changed during the copy (see
+rfSharedSnapshot in rfSharedReader.hpp).
+
+Opponent interpolation is demand-driven: readers that use the interpolated
+vehicle values must OR readerVehicleInterpolation into readerFlags at least
+once a second (see rfSharedSubscribe), otherwise the vehicle entries only
+change on scoring updates.
+
+The same data is also published as smaller segments, each in its own map
+with its own sequence, for readers that only need part of it:
+  RF_SHARED_MEMORY_TELEMETRY_NAME  player telemetry (rfTelemetrySegment)
+  RF_SHARED_MEMORY_SCORING_NAME    scoring header (rfScoringSegment)
+  RF_SHARED_MEMORY_VEHICLES_NAME   vehicle array (rfVehicleSegment)
+  RF_SHARED_MEMORY_SESSION_NAME    track/player names (rfSessionSegment)
+  RF_SHARED_MEMORY_GRAPHICS_NAME   camera and ambient light (rfGraphicsSegment)
+  RF_SHARED_MEMORY_TRACK_NAME      learned track line (rfTrackSegment)
+  RF_SHARED_MEMORY_STRINGS_NAME    interned names (rfStringTable)
+A segment's sequence advances by two on every publication, so it doubles as
+a generation counter: a reader that sees the even value it last copied can
+skip the copy (see rfSeqChanged).
+
+The main map has room for the first RF_SHARED_MEMORY_MAX_VSI_SIZE vehicles,
+whatever the vehicle segment's capacity. The vehicle segment is sized when
+the plugin starts, for up to
+RF_SHARED_MEMORY_MAX_VEHICLES vehicles: only the first capacity entries of
+rfVehicleSegment::vehicle are mapped, RF_SHARED_MEMORY_VEHICLES_SIZE(capacity)
+bytes in all, so readers map the header first to learn the capacity. On
+Windows a section keeps the size it was created with, so readers must only
+ever OpenFileMapping it: one created by a reader before the plugin starts is
+too small, and the plugin runs without the segment (rfStats::vehiclesUnmapped).
+
+Readers that would rather extrapolate vehicles at their own frame rate can
+read the raw scoring state from RF_SHARED_MEMORY_SCORING_STATE_NAME instead.
+
+Telemetry and scoring updates are stamped with rfClockSeconds() (QPC on
+Windows, CLOCK_MONOTONIC elsewhere) so readers can tell the exact age of
+each sample. Compare them against their own rfClockSeconds(), which only
+shares a time base with the plugin on the same machine.
+
+The plugin times its own callbacks with the CPU cycle counter and keeps
+call counts, max latency and log2-bucketed histograms in another small map
+(RF_SHARED_MEMORY_STATS_NAME) for monitors watching the plugin's frame time.
+
+Readers don't have to poll: telemetrySignal and scoringSignal are bumped
+after every telemetry and scoring publication (of this map and every
+segment), and readers can block on them until new data lands (see
+rfSharedOpenSignal and rfSignalWait).
+
+Readers can register in RF_SHARED_MEMORY_READERS_NAME and report the last
+telemetry frame they consumed; the plugin publishes how far behind each one
+is, so a slow consumer can be spotted (see rfReaderRegister).
+
+Every struct above is also described field by field in
+RF_SHARED_MEMORY_SCHEMA_NAME (rfSchema), generated from these definitions
+at compile time, so generic readers can look offsets up by name once at
+attach time instead of hard-coding them (see rfSchemaResolve).
+
+A second map (RF_SHARED_MEMORY_HISTORY_NAME) holds a ring of the last
+RF_SHARED_MEMORY_HISTORY_SIZE player telemetry frames so readers polling
+slower than the telemetry rate don't lose samples (see rfHistoryRead).
 */
 
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
 #define RF_SHARED_MEMORY_NAME "$rFactorShared$"
-#define RF_SHARED_MEMORY_VERSION "3.0.0.0"
-#define RF_SHARED_MEMORY_MAX_VSI_SIZE 64
+#define RF_SHARED_MEMORY_VERSION "4.0.0.0"
+#define RF_SHARED_MEMORY_MAX_VSI_SIZE 64      // entries in the main map's vehicle array
+#define RF_SHARED_MEMORY_MAX_VEHICLES 128     // most entries the vehicle segment can be sized for, a multiple of 64
+#define RF_SHARED_MEMORY_CACHE_LINE 64        // groups written at different rates are padded to this
+#define RF_SHARED_MEMORY_HISTORY_NAME "$rFactorSharedHistory$"
+#define RF_SHARED_MEMORY_HISTORY_SIZE 512    // must be a power of two
+#define RF_SHARED_MEMORY_SCORING_STATE_NAME "$rFactorSharedScoringState$"
+#define RF_SHARED_MEMORY_MAX_INTERPOLATION 0.55f  // seconds past a scoring update vehicles are extrapolated
 #define RF_SHARED_MEMORY_ACC_SMOOTH_FACTOR 0.02f
 #define RF_SHARED_MEMORY_ROT_SMOOTH_FACTOR 0.65f
+#define RF_SHARED_MEMORY_READER_TIMEOUT 1.0f  // seconds a reader flag stays active without being renewed
+#define RF_SHARED_MEMORY_TELEMETRY_NAME "$rFactorSharedTelemetry$"
+#define RF_SHARED_MEMORY_SCORING_NAME "$rFactorSharedScoring$"
+#define RF_SHARED_MEMORY_VEHICLES_NAME "$rFactorSharedVehicles$"
+#define RF_SHARED_MEMORY_SESSION_NAME "$rFactorSharedSession$"
+#define RF_SHARED_MEMORY_GRAPHICS_NAME "$rFactorSharedGraphics$"
+#define RF_SHARED_MEMORY_TRACK_NAME "$rFactorSharedTrack$"
+#define RF_SHARED_MEMORY_MAX_KNOTS 2048       // capacity of rfTrackSegment::knot
+#define RF_SHARED_MEMORY_STRINGS_NAME "$rFactorSharedStrings$"
+#define RF_SHARED_MEMORY_MAX_STRINGS 1024     // capacity of rfStringTable::text
+#define RF_SHARED_MEMORY_STRING_SIZE 64       // bytes per interned string, including the terminator
+#define RF_SHARED_MEMORY_KNOT_SPACING 4.0f    // meters of lapDist between knots on tracks short enough
+#define RF_SHARED_MEMORY_STATS_NAME "$rFactorSharedStats$"
+#define RF_SHARED_MEMORY_TELEMETRY_SIGNAL_NAME "$rFactorSharedTelemetrySignal$"
+#define RF_SHARED_MEMORY_SCORING_SIGNAL_NAME "$rFactorSharedScoringSignal$"
+#define RF_SHARED_MEMORY_READERS_NAME "$rFactorSharedReaders$"
+#define RF_SHARED_MEMORY_MAX_READERS 16
+#define RF_SHARED_MEMORY_READER_STALE 5.0     // seconds without a report before the plugin frees a reader's slot
+#define RF_SHARED_MEMORY_STATS_BUCKETS 32     // latency histogram buckets, bucket b counts [2^b, 2^(b+1)) cycles
+#define RF_SHARED_MEMORY_SCHEMA_NAME "$rFactorSharedSchema$"
+#define RF_SHARED_MEMORY_SCHEMA_STRUCTS 32    // capacity of rfSchema::structs
+#define RF_SHARED_MEMORY_SCHEMA_FIELDS 512    // capacity of rfSchema::field
 
 typedef enum {
   garage = 0,
@@ -70,6 +167,35 @@ typedef enum {
   replay = 3
 } rfControl;
 
+// bits readers set in rfShared::readerFlags to ask for optional work
+typedef enum {
+  readerVehicleInterpolation = 1  // interpolate vehicle pos/yaw/pitch/roll/speed/lapDist between scoring updates
+} rfReaderFlag;
+
+// plugin code paths timed in rfStats::probe
+typedef enum {
+  probeTelemetry = 0,       // UpdateTelemetry
+  probeScoring = 1,         // UpdateScoring
+  probeInterpolation = 2,   // vehicle interpolation inside UpdateTelemetry
+  probeCount = 3
+} rfStatsProbe;
+
+// element types in rfSchemaField::type
+typedef enum {
+  schemaStruct = 0,         // nested struct, described by rfSchema::structs[ref]
+  schemaInt8 = 1,
+  schemaUInt8 = 2,
+  schemaInt16 = 3,
+  schemaInt32 = 4,
+  schemaUInt32 = 5,
+  schemaUInt64 = 6,
+  schemaFloat = 7,
+  schemaDouble = 8,
+  schemaChar = 9,           // nul-terminated text, count is the buffer size
+  schemaBool = 10,          // one byte, 0 or 1
+  schemaUInt16 = 11
+} rfSchemaType;
+
 typedef enum {
   frontLeft = 0,
   frontRight = 1,
@@ -77,7 +203,6 @@ typedef enum {
   rearRight = 3
 } rfWheelIndex;
 
-#pragma pack(push, 1)
 
 // Our world coordinate system is left-handed, with +y pointing up.
 // The local vehicle coordinate system is as follows:
@@ -108,15 +233,45 @@ struct rfWheel {
   unsigned char surfaceType;    // 0=dry, 1=wet, 2=grass, 3=dirt, 4=gravel, 5=rumblestrip
   bool flat;                    // whether tire is flat
   bool detached;                // whether wheel is detached
+  char reserved0[1];
+  uint16_t terrainNameId;       // terrainName in the string table, 0 if empty or not interned
+  char reserved1[2];
 };
 
 // scoring info only updates twice per second (values interpolated when deltaTime > 0)!
+// the interpolated values come first and have a cache line to themselves
+// scoring updates only rewrite the cache lines of an entry that changed, and
+// stamp it with generation, so readers can copy just the entries that moved on;
+// the interpolated values always go back to the raw ones while deltaTime == 0
 struct rfVehicleInfo {
+  // Position and derivatives (interpolated at the telemetry rate)
+  rfVec3 pos;					// world position in meters
+
+  float yaw;					// rad, use (360-yaw*57.2978)%360 for heading in degrees
+  float pitch;					// rad
+  float roll;					// rad
+
+  float speed;					// meters/sec
+  float lapDist;                // current distance around track
+
+  // Relative gaps (see rfGapEngine, also at the telemetry rate)
+  // worked out from the interpolated lapDist, so like it they only move while a
+  // reader sets readerVehicleInterpolation, and otherwise keep their last values
+  // the vehicle indices cover the whole field, so they can name vehicles only the
+  // other map has: RF_SHARED_MEMORY_MAX_VSI_SIZE or more in the main map, capacity
+  // or more in the vehicle segment
+  float distanceAhead;          // meters to the next vehicle ahead on track, whatever lap it's on
+  float timeAhead;              // seconds since that vehicle was where this one is now
+  float distanceBehind;         // meters to the next vehicle behind on track
+  float timeBehind;             // seconds until that vehicle gets to where this one is now
+  signed char vehicleAhead;     // index of the vehicle ahead on track, -1 if none
+  signed char vehicleBehind;    // index of the vehicle behind on track, -1 if none
+  char reserved0[14];
+
   char driverName[32];          // driver name
   short totalLaps;              // laps completed
   signed char sector;           // 0=sector3, 1=sector1, 2=sector2 (don't ask why)
   signed char finishStatus;     // 0=none, 1=finished, 2=dnf, 3=dq
-  float lapDist;                // current distance around track
   float pathLateral;            // lateral position with respect to *very approximate* "center" path
   float trackEdge;              // track edge (w.r.t. "center" path) on same side of track as vehicle
 
@@ -140,26 +295,58 @@ struct rfVehicleInfo {
 
   // Dash Indicators
   float timeBehindNext;         // time behind vehicle in next higher place
-  long lapsBehindNext;          // laps behind vehicle in next higher place
+  int32_t lapsBehindNext;       // laps behind vehicle in next higher place
   float timeBehindLeader;       // time behind leader
-  long lapsBehindLeader;        // laps behind leader
+  int32_t lapsBehindLeader;     // laps behind leader
   float lapStartET;             // time this lap was started
+  uint16_t driverNameId;        // driverName in the string table, 0 if empty or not interned
+  uint16_t vehicleClassNameId;  // vehicleClass in the string table, 0 if empty or not interned
+  uint32_t generation;          // scoringGeneration of the last scoring update that changed this entry
+  char reserved1[48];
+};
 
-  // Position and derivatives
-  rfVec3 pos;					// world position in meters
-
-  float yaw;					// rad, use (360-yaw*57.2978)%360 for heading in degrees
-  float pitch;					// rad
-  float roll;					// rad
-
-  float speed;					// meters/sec
+// standings as permutations of the vehicle array, so readers can walk the
+// field in place order overall or within a class without sorting it
+// rebuilt only when a scoring update changes a place, a class or the field
+// covers the whole field, so indices at or past RF_SHARED_MEMORY_MAX_VSI_SIZE
+// in the main map, or capacity in the vehicle segment, refer to vehicles only
+// the other map has
+struct rfStandings {
+  uint32_t generation;          // bumped every time the standings are rebuilt
+  int32_t numVehicles;          // entries in overall and byClass
+  int32_t numClasses;           // entries in classStart and classCount
+  char reserved0[52];
+  unsigned char overall[RF_SHARED_MEMORY_MAX_VEHICLES];        // vehicle index in each place, overall[0] leads
+  unsigned char byClass[RF_SHARED_MEMORY_MAX_VEHICLES];        // vehicle indices grouped by class, in place order within each
+  unsigned char classStart[RF_SHARED_MEMORY_MAX_VEHICLES];     // first entry of each class in byClass, classes in order of their leaders
+  unsigned char classCount[RF_SHARED_MEMORY_MAX_VEHICLES];     // vehicles in each class
+  unsigned char vehicleClassId[RF_SHARED_MEMORY_MAX_VEHICLES]; // class of each vehicle index
+  unsigned char classPlace[RF_SHARED_MEMORY_MAX_VEHICLES];     // 1-based place of each vehicle index within its class
 };
 
+// groups written at different rates start on their own cache line, so the
+// player telemetry written ~90 times a second doesn't keep invalidating the
+// lines readers of the scoring block and vehicle array are polling
 struct rfShared {
+  // Header (written by every update)
   char version[8];				// API version
-  // Time
+  uint32_t sequence;            // odd while an update is in progress, even when consistent
+  float currentET;              // current time (extrapolated between scoring updates)
+  bool inRealtime;              // in realtime as opposed to at the monitor
+  char reserved0[47];
+
+  // Written by readers (and the wakeup counters, by both sides)
+  uint32_t readerFlags;         // rfReaderFlag bits OR'd in by readers, cleared by the plugin once seen
+  uint32_t telemetrySignal;     // bumped after every telemetry publication, see rfSharedOpenSignal
+  uint32_t telemetryWaiters;    // readers blocked on telemetrySignal
+  uint32_t scoringSignal;       // bumped after every scoring publication
+  uint32_t scoringWaiters;      // readers blocked on scoringSignal
+  char reserved1[44];
+
+  // Player telemetry (written at the telemetry rate)
+  double telemetryTime;         // rfClockSeconds() when the current telemetry frame was published
   float deltaTime;              // time since last scoring update (seconds)
-  long lapNumber;               // current lap number
+  int32_t lapNumber;            // current lap number
   float lapStartET;             // time this lap was started
   char trackName[64];           // current track name
 
@@ -178,7 +365,7 @@ struct rfShared {
   float speed;				// meters/sec
 
   // Vehicle status
-  long gear;                    // -1=reverse, 0=neutral, 1+=forward gears
+  int32_t gear;                 // -1=reverse, 0=neutral, 1+=forward gears
   float engineRPM;              // engine RPM
   float engineWaterTemp;        // Celsius
   float engineOilTemp;          // Celsius
@@ -204,15 +391,18 @@ struct rfShared {
   rfVec3 lastImpactPos;     // location of last impact
 
   rfWheel wheel[4];        // wheel info (front left, front right, rear left, rear right)
+  uint16_t trackNameId;         // trackName in the string table, 0 if empty or not interned
+  char reserved2[22];
 
   // scoring info only updates twice per second (values interpolated when deltaTime > 0)!
-  long session;                 // current session
-  float currentET;              // current time
+  double scoringTime;           // rfClockSeconds() when the last scoring update was published
+  float scoringET;              // session time (mCurrentET) of the last scoring update
+  int32_t session;              // current session
   float endET;                  // ending time
-  long  maxLaps;                // maximum laps
+  int32_t maxLaps;              // maximum laps
   float lapDist;                // distance around track
 
-  long numVehicles;             // current number of vehicles
+  int32_t numVehicles;          // current number of vehicles
 
   unsigned char gamePhase;   
 
@@ -221,15 +411,347 @@ struct rfShared {
   signed char sectorFlag[3];      // whether there are any local yellows at the moment in each sector (not sure if sector 0 is first or last, so test)
   unsigned char startLight;       // start light frame (number depends on track)
   unsigned char numRedLights;     // number of red lights in start sequence
-  bool inRealtime;                // in realtime as opposed to at the monitor
   char playerName[32];            // player name (including possible multiplayer override)
 
   // weather
   float ambientTemp;              // temperature (Celsius)
   float trackTemp;                // temperature (Celsius)
   rfVec3 wind;                // wind speed
+  uint32_t scoringGeneration;   // scoring updates since Startup
+  uint64_t changedVehicles;     // bit i set if the last scoring update changed vehicle[i]
+  char reserved3[24];
 
   rfVehicleInfo vehicle[RF_SHARED_MEMORY_MAX_VSI_SIZE];  // array of vehicle scoring info's
+  rfStandings standings;        // vehicle in place order, overall and by class
+};
+
+// player telemetry frame as kept in the history ring
+// everything from telemetryTime to trackNameId is laid out exactly as in rfShared
+struct rfTelemetryFrame {
+  uint32_t sequence;            // frame number (1-based), 0 while the slot is being written
+  float currentET;              // estimated session time of this frame
+
+  double telemetryTime;         // rfClockSeconds() when the frame was published
+  float deltaTime;              // time since last scoring update (seconds)
+  int32_t lapNumber;            // current lap number
+  float lapStartET;             // time this lap was started
+  char trackName[64];           // current track name
+
+  rfVec3 pos;               // world position in meters
+  rfVec3 localVel;          // velocity (meters/sec) in local vehicle coordinates
+  rfVec3 localAccel;        // acceleration (meters/sec^2) in local vehicle coordinates
+  rfVec3 oriX;              // top row of orientation matrix
+  rfVec3 oriY;              // mid row of orientation matrix
+  rfVec3 oriZ;              // bot row of orientation matrix
+  rfVec3 localRot;          // rotation (radians/sec) in local vehicle coordinates
+  rfVec3 localRotAccel;     // rotational acceleration (radians/sec^2) in local vehicle coordinates
+  float speed;				// meters/sec
+
+  int32_t gear;                 // -1=reverse, 0=neutral, 1+=forward gears
+  float engineRPM;              // engine RPM
+  float engineWaterTemp;        // Celsius
+  float engineOilTemp;          // Celsius
+  float clutchRPM;              // clutch RPM
+
+  float unfilteredThrottle;     // ranges  0.0-1.0
+  float unfilteredBrake;        // ranges  0.0-1.0
+  float unfilteredSteering;     // ranges -1.0-1.0 (left to right)
+  float unfilteredClutch;       // ranges  0.0-1.0
+
+  float steeringArmForce;       // force on steering arms
+  float fuel;                   // amount of fuel (liters)
+  float engineMaxRPM;           // rev limit
+  unsigned char scheduledStops; // number of scheduled pitstops
+  bool  overheating;            // whether overheating icon is shown
+  bool  detached;               // whether any parts (besides wheels) have been detached
+  unsigned char dentSeverity[8];// dent severity at 8 locations around the car (0=none, 1=some, 2=more)
+  float lastImpactET;           // time of last impact
+  float lastImpactMagnitude;    // magnitude of last impact
+  rfVec3 lastImpactPos;     // location of last impact
+
+  rfWheel wheel[4];        // wheel info (front left, front right, rear left, rear right)
+  uint16_t trackNameId;         // trackName in the string table, 0 if empty or not interned
+  char reserved0[6];
+};
+
+// player telemetry segment
+struct rfTelemetrySegment {
+  char version[8];				// API version
+  uint32_t sequence;            // odd while an update is in progress, even when consistent
+  char reserved0[52];
+  rfTelemetryFrame telemetry;   // telemetry.sequence counts telemetry updates since Startup
+};
+
+// scoring header segment, updated twice per second
+struct rfScoringSegment {
+  char version[8];				// API version
+  uint32_t sequence;            // odd while an update is in progress, even when consistent
+  char reserved0[52];
+
+  double scoringTime;           // rfClockSeconds() when the scoring update was published
+  float currentET;              // session time (mCurrentET) of the scoring update
+  int32_t session;              // current session
+  float endET;                  // ending time
+  int32_t maxLaps;              // maximum laps
+  float lapDist;                // distance around track
+  int32_t numVehicles;          // current number of vehicles
+  unsigned char gamePhase;
+  signed char yellowFlagState;
+  signed char sectorFlag[3];    // whether there are any local yellows at the moment in each sector
+  unsigned char startLight;     // start light frame (number depends on track)
+  unsigned char numRedLights;   // number of red lights in start sequence
+  bool inRealtime;              // in realtime as opposed to at the monitor
+  float ambientTemp;            // temperature (Celsius)
+  float trackTemp;              // temperature (Celsius)
+  rfVec3 wind;                  // wind speed
+};
+
+// vehicle array segment, updated on scoring updates and, while a reader asks
+// for readerVehicleInterpolation in rfShared, at the telemetry rate
+struct rfVehicleSegment {
+  char version[8];				// API version
+  uint32_t sequence;            // odd while an update is in progress, even when consistent
+  int32_t numVehicles;          // number of valid entries in vehicle, at most capacity
+  double scoringTime;           // rfClockSeconds() of the scoring update the entries come from
+  float currentET;              // session time the interpolated values correspond to
+  uint32_t scoringGeneration;   // scoring updates since Startup
+  uint64_t changedVehicles[RF_SHARED_MEMORY_MAX_VEHICLES / 64]; // bit i % 64 of word i / 64 set if the last scoring update changed vehicle[i]
+  uint32_t capacity;            // entries of vehicle that are mapped, fixed when the plugin starts
+  char reserved0[12];
+  rfStandings standings;        // vehicle in place order, overall and by class
+  rfVehicleInfo vehicle[RF_SHARED_MEMORY_MAX_VEHICLES]; // only the first capacity are mapped
+};
+
+// bytes mapped for a vehicle segment with room for capacity vehicles
+#define RF_SHARED_MEMORY_VEHICLES_SIZE(capacity) (offsetof(rfVehicleSegment, vehicle) + (size_t)(capacity) * sizeof(rfVehicleInfo))
+
+// rarely changing session info, only republished when one of the names changes
+struct rfSessionSegment {
+  char version[8];				// API version
+  uint32_t sequence;            // odd while an update is in progress, even when consistent
+  char reserved0[52];
+  char trackName[64];           // current track name
+  char playerName[32];          // player name (including possible multiplayer override)
+  char plrFileName[64];         // PLR file name of the player profile
+};
+
+// camera and scene lighting, republished on every rendered frame
+// rFactor's GraphicsInfoV2 carries no camera vehicle or camera type, only what's here
+struct rfGraphicsSegment {
+  char version[8];				// API version
+  uint32_t sequence;            // odd while an update is in progress, even when consistent
+  uint32_t frames;              // graphics updates since Startup
+  char reserved0[48];
+  double graphicsTime;          // rfClockSeconds() when the frame was published
+  rfVec3 camPos;                // camera position in world coordinates (meters)
+  rfVec3 camOri;                // camera orientation, as given by the sim
+  float ambientRed;             // ambient light colour
+  float ambientGreen;
+  float ambientBlue;
+};
+
+// one point of the learned track line
+struct rfTrackKnot {
+  rfVec3 pos;                   // mean world position of vehicles passing this lapDist
+  float heading;                // direction of the line here, atan2(dx, dz) of its tangent (radians)
+  float weight;                 // samples behind pos, 0 until a vehicle has passed
+};
+
+// line driven around the current track, learned from every vehicle's pos and
+// lapDist on scoring updates and cached on disk between sessions (see rfTrack.hpp)
+// knot k sits at lapDist k * spacing, the line is closed (knot numKnots is knot 0)
+// only knots that changed are rewritten, use rfSeqChanged before taking a copy
+struct rfTrackSegment {
+  char version[8];				// API version
+  uint32_t sequence;            // odd while an update is in progress, even when consistent
+  uint32_t numKnots;            // valid entries in knot, 0 until the lap length is known
+  float length;                 // lap length (meters)
+  float spacing;                // lapDist between knots (meters)
+  uint32_t learned;             // knots with a weight
+  char reserved0[36];
+  char trackName[64];           // track the line belongs to
+  rfTrackKnot knot[RF_SHARED_MEMORY_MAX_KNOTS];
+};
+
+// names seen by the plugin, each stored once under an id that stays the same
+// until Shutdown; records carry the ids next to their own copies of the names,
+// so readers can compare names as integers
+// the table only ever grows: text[id] never changes once numStrings is past id,
+// so a reader can look an id up in the mapped table without a snapshot (see
+// rfStringLookup); id 0 is the empty string and stands in for names that
+// didn't fit once the table is full
+struct rfStringTable {
+  char version[8];				// API version
+  uint32_t sequence;            // odd while a string is being added, even when consistent
+  uint32_t numStrings;          // ids below this are valid
+  char reserved0[48];
+  char text[RF_SHARED_MEMORY_MAX_STRINGS][RF_SHARED_MEMORY_STRING_SIZE];
+};
+
+// vehicle state as structure-of-arrays, the layout the interpolation kernels work on
+struct rfVec3SoA {
+  float x[RF_SHARED_MEMORY_MAX_VEHICLES];
+  float y[RF_SHARED_MEMORY_MAX_VEHICLES];
+  float z[RF_SHARED_MEMORY_MAX_VEHICLES];
+};
+
+// vehicle state as of the last scoring update
+struct rfVehicleStateSoA {
+  float lapDist[RF_SHARED_MEMORY_MAX_VEHICLES];
+  rfVec3SoA pos;
+  rfVec3SoA localVel;
+  rfVec3SoA localAccel;
+  rfVec3SoA oriX;
+  rfVec3SoA oriY;
+  rfVec3SoA oriZ;
+  rfVec3SoA localRot;
+  rfVec3SoA localRotAccel;
+};
+
+// raw scoring state for readers that interpolate themselves (see rfInterpolateScoringState)
+// published on every scoring update under the same sequence lock protocol as rfShared
+struct rfScoringState {
+  char version[8];				// API version
+  uint32_t sequence;            // odd while an update is in progress, even when consistent
+  int32_t numVehicles;          // number of valid entries in vehicle
+  double scoringTime;           // rfClockSeconds() when the scoring update arrived
+  float currentET;              // session time of the scoring update
+  char reserved0[36];
+  rfVehicleStateSoA vehicle;
+};
+
+// single-producer ring of recent telemetry frames
+// frame n (1-based) lives in frame[(n - 1) % RF_SHARED_MEMORY_HISTORY_SIZE]
+struct rfHistory {
+  char version[8];				// API version
+  uint32_t capacity;            // number of frames in the ring
+  uint32_t head;                // sequence of the newest complete frame (0 = none yet)
+  char reserved0[48];
+  rfTelemetryFrame frame[RF_SHARED_MEMORY_HISTORY_SIZE];
+};
+
+// latency of one plugin code path since Startup, in CPU cycles (see rfCycles)
+struct rfLatencyStats {
+  uint64_t calls;               // number of timed calls
+  uint64_t totalCycles;         // sum of all call latencies
+  uint64_t maxCycles;           // slowest call
+  uint64_t bucket[RF_SHARED_MEMORY_STATS_BUCKETS]; // calls taking [2^b, 2^(b+1)) cycles, the last bucket is open-ended
+};
+
+// plugin instrumentation, published under the same sequence lock protocol as rfShared
+struct rfStats {
+  char version[8];				// API version
+  uint32_t sequence;            // odd while an update is in progress, even when consistent
+  int32_t numProbes;            // number of entries in probe (probeCount)
+  double cyclesPerSecond;       // cycle counter rate, 0 until the first scoring update
+  rfLatencyStats probe[probeCount]; // indexed by rfStatsProbe
+
+  // session recorder (see rfRecorder.hpp), refreshed on scoring updates
+  bool recording;               // a session is being recorded
+  bool recordFailed;            // the capture file couldn't be grown, the rest of the session is lost
+  bool vehiclesUnmapped;        // RF_SHARED_MEMORY_VEHICLES_NAME couldn't be mapped at startup, e.g. a reader created it too small
+  char reserved0[5];
+  uint64_t recordedRecords;     // records queued this session
+  uint64_t droppedRecords;      // records dropped because the writer fell behind
+  uint64_t recordedBytes;       // bytes written to the capture file
+};
+
+// one registered reader, written only by the reader that owns it
+struct rfReaderSlot {
+  uint32_t owner;               // registration token, 0 if the slot is free (claimed with a compare-exchange)
+  uint32_t pid;                 // owning process id
+  double heartbeat;             // rfClockSeconds() of the reader's last report, 0 while (un)registering
+  uint32_t cursor;              // sequence of the last telemetry frame the reader consumed
+  char reserved0[4];
+  char name[32];                // what the reader calls itself, e.g. "dash"
+  char reserved1[8];
+};
+
+// how far behind one reader is, written by the plugin on every telemetry update
+struct rfReaderStatus {
+  uint32_t owner;               // registration the counters belong to, reset when the slot changes hands
+  uint32_t lag;                 // frames published past the reader's cursor
+  uint32_t maxLag;              // worst lag since the reader registered
+  uint32_t overruns;            // times lag went past RF_SHARED_MEMORY_HISTORY_SIZE, i.e. history was lost
+};
+
+// reader registration table; the slots and the status the plugin writes about
+// them are kept apart so neither side keeps invalidating the other's lines
+// telemetry frames are numbered as in rfHistory and rfTelemetrySegment
+struct rfReaderTable {
+  char version[8];				// API version
+  uint32_t numSlots;            // RF_SHARED_MEMORY_MAX_READERS
+  uint32_t head;                // sequence of the newest telemetry frame
+  uint32_t registrations;       // registrations so far, source of the owner tokens
+  char reserved0[44];
+  rfReaderSlot slot[RF_SHARED_MEMORY_MAX_READERS];
+  rfReaderStatus status[RF_SHARED_MEMORY_MAX_READERS];
+};
+
+// one member of a struct described in rfSchema
+// arrays are flattened to count elements of size bytes; rfVec3 is three floats
+struct rfSchemaField {
+  char name[32];                // member name as declared above
+  char unit[12];                // unit of each element, e.g. "m/s" or "degC", empty if none
+  uint16_t type;                // rfSchemaType of each element
+  uint16_t ref;                 // index into rfSchema::structs for schemaStruct elements, 0 otherwise
+  uint32_t offset;              // bytes from the start of the enclosing struct
+  uint32_t size;                // bytes per element
+  uint32_t count;               // number of elements, 1 for plain members
+  char reserved0[4];
+};
+
+// one struct described in rfSchema, its fields are in declaration order
+struct rfSchemaStruct {
+  char name[24];                // struct name as declared above, e.g. "rfShared"
+  char map[32];                 // map the struct is published as, empty for nested structs
+  uint32_t size;                // sizeof the struct
+  uint16_t firstField;          // index into rfSchema::field
+  uint16_t numFields;
+};
+
+// field descriptors of every published struct, written once at Startup
+// under the same sequence lock protocol as rfShared; reserved fields are left out
+struct rfSchema {
+  char version[8];				// API version the layout belongs to
+  uint32_t sequence;            // odd while an update is in progress, even when consistent
+  uint32_t numStructs;          // valid entries in structs
+  uint32_t numFields;           // valid entries in field
+  char reserved0[44];
+  rfSchemaStruct structs[RF_SHARED_MEMORY_SCHEMA_STRUCTS];
+  rfSchemaField field[RF_SHARED_MEMORY_SCHEMA_FIELDS];
 };
 
-#pragma pack(pop)
+// layout checks, readers in other languages rely on these offsets
+static_assert(sizeof(rfWheel) == 72, "rfWheel layout changed");
+static_assert(offsetof(rfVehicleInfo, driverName) == RF_SHARED_MEMORY_CACHE_LINE, "interpolated vehicle values must fill the first cache line");
+static_assert(sizeof(rfVehicleInfo) == 4 * RF_SHARED_MEMORY_CACHE_LINE, "rfVehicleInfo layout changed");
+static_assert(RF_SHARED_MEMORY_MAX_VSI_SIZE <= 64, "changedVehicles has one bit per vehicle");
+static_assert(offsetof(rfShared, readerFlags) == 1 * RF_SHARED_MEMORY_CACHE_LINE, "rfShared layout changed");
+static_assert(offsetof(rfShared, telemetryTime) == 2 * RF_SHARED_MEMORY_CACHE_LINE, "rfShared layout changed");
+static_assert(offsetof(rfShared, scoringTime) == 11 * RF_SHARED_MEMORY_CACHE_LINE, "rfShared layout changed");
+static_assert(offsetof(rfShared, vehicle) == 13 * RF_SHARED_MEMORY_CACHE_LINE, "rfShared layout changed");
+static_assert(RF_SHARED_MEMORY_MAX_VEHICLES % 64 == 0 && RF_SHARED_MEMORY_MAX_VEHICLES >= RF_SHARED_MEMORY_MAX_VSI_SIZE &&
+	RF_SHARED_MEMORY_MAX_VEHICLES < 256, "standings index vehicles with an unsigned char");
+static_assert(sizeof(rfStandings) == 13 * RF_SHARED_MEMORY_CACHE_LINE, "rfStandings layout changed");
+static_assert(sizeof(rfShared) == 13 * RF_SHARED_MEMORY_CACHE_LINE + RF_SHARED_MEMORY_MAX_VSI_SIZE * sizeof(rfVehicleInfo) + sizeof(rfStandings), "rfShared layout changed");
+static_assert(sizeof(rfTelemetryFrame) == 568, "rfTelemetryFrame layout changed");
+static_assert(offsetof(rfTelemetryFrame, trackNameId) - offsetof(rfTelemetryFrame, telemetryTime) ==
+	offsetof(rfShared, trackNameId) - offsetof(rfShared, telemetryTime), "rfTelemetryFrame out of sync with rfShared");
+static_assert(offsetof(rfTelemetrySegment, telemetry) == RF_SHARED_MEMORY_CACHE_LINE, "rfTelemetrySegment layout changed");
+static_assert(offsetof(rfScoringSegment, scoringTime) == RF_SHARED_MEMORY_CACHE_LINE, "rfScoringSegment layout changed");
+static_assert(sizeof(rfScoringSegment) == 2 * RF_SHARED_MEMORY_CACHE_LINE, "rfScoringSegment layout changed");
+static_assert(offsetof(rfVehicleSegment, standings) == RF_SHARED_MEMORY_CACHE_LINE, "rfVehicleSegment layout changed");
+static_assert(offsetof(rfVehicleSegment, vehicle) == RF_SHARED_MEMORY_CACHE_LINE + sizeof(rfStandings), "rfVehicleSegment layout changed");
+static_assert(offsetof(rfSessionSegment, trackName) == RF_SHARED_MEMORY_CACHE_LINE, "rfSessionSegment layout changed");
+static_assert(offsetof(rfGraphicsSegment, graphicsTime) == RF_SHARED_MEMORY_CACHE_LINE, "rfGraphicsSegment layout changed");
+static_assert(offsetof(rfTrackSegment, knot) == 2 * RF_SHARED_MEMORY_CACHE_LINE, "rfTrackSegment layout changed");
+static_assert(offsetof(rfStringTable, text) == RF_SHARED_MEMORY_CACHE_LINE, "rfStringTable layout changed");
+static_assert(offsetof(rfScoringState, vehicle) == RF_SHARED_MEMORY_CACHE_LINE, "rfScoringState layout changed");
+static_assert(offsetof(rfHistory, frame) == RF_SHARED_MEMORY_CACHE_LINE, "rfHistory layout changed");
+static_assert(offsetof(rfStats, probe) == 24, "rfStats layout changed");
+static_assert(sizeof(rfReaderSlot) == RF_SHARED_MEMORY_CACHE_LINE, "rfReaderSlot layout changed");
+static_assert(offsetof(rfReaderTable, slot) == RF_SHARED_MEMORY_CACHE_LINE, "rfReaderTable layout changed");
+static_assert(sizeof(rfSchemaField) == RF_SHARED_MEMORY_CACHE_LINE, "rfSchemaField layout changed");
+static_assert(sizeof(rfSchemaStruct) == RF_SHARED_MEMORY_CACHE_LINE, "rfSchemaStruct layout changed");
+static_assert(offsetof(rfSchema, structs) == RF_SHARED_MEMORY_CACHE_LINE, "rfSchema layout changed");
@@ -0,0 +1,32 @@
+/*
+rfStandings.hpp
+by Dan Allongo (daniel.s.allongo@gmail.com)
+
+Keeps rfStandings in step with the vehicle array. The places and classes of
+the field only change now and then (an overtake, a pit stop), so each scoring
+update just compares them against the last ones seen and the permutations are
+only rebuilt when one of them changed.
+*/
+
+#pragma once
+
+#include "rfSharedStruct.hpp"
+
+class rfStandingsBuilder {
+ public:
+  rfStandingsBuilder();
+
+  // forget the last field seen, so the next Update rebuilds
+  void Reset();
+  // rebuild standings from the first count vehicles if a place, a class or the
+  // number of vehicles changed since the last call, true if it did
+  bool Update(const rfVehicleInfo *vehicle, int count, rfStandings &standings);
+
+ private:
+  void Rebuild(const rfVehicleInfo *vehicle, rfStandings &standings);
+
+  int count;                    // vehicles in the last field seen, -1 to force a rebuild
+  uint32_t generation;
+  unsigned char place[RF_SHARED_MEMORY_MAX_VEHICLES];
+  char vehicleClass[RF_SHARED_MEMORY_MAX_VEHICLES][32];
+};
@@ -0,0 +1,31 @@
+/*
+rfStrings.hpp
+by Dan Allongo (daniel.s.allongo@gmail.com)
+
+Interns the names the plugin publishes (track, driver, vehicle class and
+terrain names) into rfStringTable. The index is an open-addressed hash of
+ids into the table itself, so looking a name up reads the mapped text it
+was stored in rather than a private copy. The plugin only asks when a name
+in a record changed, which is a handful of times per session.
+*/
+
+#pragma once
+
+#include "rfSharedStruct.hpp"
+
+#define RF_STRINGS_HASH_SIZE 2048    // slots in the index, a power of two at least twice RF_SHARED_MEMORY_MAX_STRINGS
+
+class rfStringInterner {
+ public:
+  rfStringInterner();
+
+  // empty table and index, with id 0 holding the empty string
+  void Reset(rfStringTable &table);
+  // id of s in table, 0 if it isn't there
+  uint16_t Find(const rfStringTable &table, const char *s) const;
+  // append s to table, 0 if it's full; the caller holds the table's sequence lock
+  uint16_t Add(rfStringTable &table, const char *s);
+
+ private:
+  uint16_t slot[RF_STRINGS_HASH_SIZE]; // ids, 0 for an empty slot
+};
@@ -0,0 +1,89 @@
+/*
+rfTrack.hpp
+by Dan Allongo (daniel.s.allongo@gmail.com)
+
+Learns the line driven around a track from the pos and lapDist of every
+vehicle on each scoring update, for publication in rfTrackSegment. Each
+sample is split between the two knots either side of its lapDist, weighted
+by how close it is to each and slid along the line to each knot's lapDist,
+and every knot keeps a running mean of what it was given, so the line
+settles on the middle of where cars drive within a few laps of a full field.
+A knot stops learning once it has RF_TRACK_MAX_WEIGHT samples, so a settled
+(or cached) line costs the scoring update next to nothing.
+
+The line is cached per track in <dir>/rfTrack-<trackName>.rftrk:
+
+  rfTrackFileHeader | rfTrackKnot[numKnots]
+
+The cache is read and written on a background thread so the sim's thread
+never waits on the disk; a cached line that arrives after learning started
+is merged with whatever was learned meanwhile.
+*/
+
+#pragma once
+
+#include "rfSharedStruct.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define RF_TRACK_MAGIC 0x4B525452     // "RTRK"
+#define RF_TRACK_VERSION 1
+#define RF_TRACK_MAX_WEIGHT 256.0f    // samples after which a knot has settled
+
+#pragma pack(push, 1)
+
+struct rfTrackFileHeader {
+  unsigned int magic;           // RF_TRACK_MAGIC
+  unsigned int version;         // RF_TRACK_VERSION
+  unsigned int numKnots;        // knots following the header
+  float length;                 // lap length the knots were learned at
+  char trackName[64];
+};
+
+#pragma pack(pop)
+
+class rfTrackLearner {
+ public:
+  rfTrackLearner();
+  ~rfTrackLearner();
+
+  // whether the line being learned is for this track and lap length
+  bool Matches(const char *trackName, float lapLength) const;
+  // save the current line to dir and start on another track, picking up its
+  // cached line from dir if there is one (dir may be NULL to skip the cache)
+  void Reset(const char *trackName, float lapLength, const char *dir);
+  // one vehicle at lapDist with world position pos
+  void Add(float lapDist, const rfVec3 &pos);
+  // copy the knots changed since the last Flush into seg, the caller holds its sequence lock
+  void Flush(rfTrackSegment &seg);
+  // write the line to dir in the background if it changed since it was loaded or saved
+  void Save(const char *dir);
+  // wait for the background cache I/O
+  void Stop();
+
+ private:
+  void Aim(uint32_t k);
+  void Touch(uint32_t k);
+  void Merge();                 // fold in a cached line the loader finished reading
+  void Start(const std::string &savePath, std::vector<char> &saveData, const std::string &loadPath);
+  void Run(std::string savePath, std::vector<char> saveData, std::string loadPath, rfTrackFileHeader expected);
+  bool CachePath(char *path, size_t size, const char *dir) const;
+
+  char name[64];
+  float length;
+  float spacing;
+  uint32_t numKnots;
+  uint32_t learned;
+  bool full;                    // the next Flush copies every knot
+  bool dirty;                   // learned something since the line was loaded or saved
+  rfTrackKnot knot[RF_SHARED_MEMORY_MAX_KNOTS];
+  rfVec3 tangent[RF_SHARED_MEMORY_MAX_KNOTS]; // unit direction of the line at each knot, 0 until both neighbours are learned
+  bool marked[RF_SHARED_MEMORY_MAX_KNOTS];
+  uint16_t pending[RF_SHARED_MEMORY_MAX_KNOTS]; // knots changed since the last Flush
+  uint32_t numPending;
+  std::thread io;
+  std::atomic<bool> loaded;     // set by the I/O thread once cache holds the cached line
+  std::vector<rfTrackKnot> cache;
+};
@@ -14,6 +14,11 @@
 #include "rFactorSharedMemoryMap.hpp"
 #include <math.h>
 #include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <atomic>
 
 
 // plugin information
@@ -24,17 +29,17 @@ unsigned g_uPluginObjectCount = 1;
 InternalsPluginInfo g_PluginInfo;
 
 // interface to plugin information
-extern "C" __declspec(dllexport)
+RF_PLUGIN_EXPORT
 const char* __cdecl GetPluginName() { return g_szPluginName; }
 
-extern "C" __declspec(dllexport)
+RF_PLUGIN_EXPORT
 unsigned __cdecl GetPluginVersion() { return g_uPluginVersion; }
 
-extern "C" __declspec(dllexport)
+RF_PLUGIN_EXPORT
 unsigned __cdecl GetPluginObjectCount() { return g_uPluginObjectCount; }
 
 // get the plugin-info object used to create the plugin.
-extern "C" __declspec(dllexport)
+RF_PLUGIN_EXPORT
 PluginObjectInfo* __cdecl GetPluginObjectInfo( const unsigned uIndex ) {
   switch(uIndex) {
     case 0:
@@ -72,93 +77,465 @@ PluginObjectInfo *SharedMemoryMapPlugin::GetInfo() {
   return &g_PluginInfo;
 }
 
-void SharedMemoryMapPlugin::Startup() {
+// readers retry their copy while the sequence is odd
+static inline void SeqBegin(uint32_t &shared, uint32_t &sequence) {
+	*(volatile uint32_t*)&shared = ++sequence;
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+static inline void SeqEnd(uint32_t &shared, uint32_t &sequence) {
+	std::atomic_thread_fence(std::memory_order_release);
+	*(volatile uint32_t*)&shared = ++sequence;
+}
+
+// zero a segment published under a sequence lock, everything but its sequence
+// size is what's mapped, which is less than sizeof(T) for the vehicle segment
+template <class T>
+static void ClearSegment(T *seg, uint32_t &sequence, size_t size = sizeof(T)) {
+	size_t afterSequence = offsetof(T, sequence) + sizeof(seg->sequence);
+	SeqBegin(seg->sequence, sequence);
+	memset((char*)seg + afterSequence, 0, size - afterSequence);
+	strcpy(seg->version, RF_SHARED_MEMORY_VERSION);
+	SeqEnd(seg->sequence, sequence);
+}
+
+// map one of the optional segments, NULL if it couldn't be created
+template <class T>
+static T* MapSegment(rfMapping &map, const char *name, uint32_t &sequence, size_t size = sizeof(T)) {
 	char tag[256] = {};
-	strcpy(tag, RF_SHARED_MEMORY_NAME);
-	char exe[1024] = {};
-	GetModuleFileName(NULL, exe, sizeof(exe));
-	char pid[8] = {};
-	sprintf(pid, "%d", GetCurrentProcessId());
-	// append processId for dedicated server to allow multiple instances
-	if (strstr(exe, "Dedicated.exe") != NULL) {
-		strcat(tag, pid);
-	}
-	// init handle and try to create, read if existing
-	hMap = INVALID_HANDLE_VALUE;
-	hMap = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(rfShared), TEXT(tag));
-	if (hMap == NULL) {
-		if (GetLastError() == (DWORD)183) {
-			hMap = OpenFileMapping(FILE_MAP_ALL_ACCESS, FALSE, TEXT(tag));
-			if (hMap == NULL) {
-				// unable to create or read existing
-				mapped = FALSE;
-				return;
-			}
-		}
+	rfMapName(tag, sizeof(tag), name);
+	T *seg = (T*)rfMapCreate(map, tag, size);
+	if (seg) {
+		// carry on from an existing sequence so attached readers see a change
+		sequence = seg->sequence & ~1U;
+		ClearSegment(seg, sequence, size);
 	}
-	pBuf = (rfShared*)MapViewOfFile(hMap, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(rfShared));
+	return seg;
+}
+
+// how many vehicles to keep track of, from PLUGIN_VEHICLES_VAR
+static int VehicleCapacity() {
+	const char *value = getenv(PLUGIN_VEHICLES_VAR);
+	int capacity = value != NULL && value[0] != 0 ? atoi(value) : RF_SHARED_MEMORY_MAX_VSI_SIZE;
+	if (capacity < 1) {
+		capacity = 1;
+	}
+	return capacity < RF_SHARED_MEMORY_MAX_VEHICLES ? capacity : RF_SHARED_MEMORY_MAX_VEHICLES;
+}
+
+// where learned track lines are cached
+static const char* TrackDir() {
+	const char *dir = getenv(PLUGIN_TRACK_DIR_VAR);
+	return dir != NULL && dir[0] != 0 ? dir : PLUGIN_TRACK_DIR_DEFAULT;
+}
+
+void SharedMemoryMapPlugin::Startup() {
+	char tag[256] = {};
+	rfMapName(tag, sizeof(tag), RF_SHARED_MEMORY_NAME);
+	char historyTag[256] = {};
+	rfMapName(historyTag, sizeof(historyTag), RF_SHARED_MEMORY_HISTORY_NAME);
+	pHistory = NULL;
+	pTelemetry = NULL;
+	pScoring = NULL;
+	pVehicles = NULL;
+	pSession = NULL;
+	pGraphics = NULL;
+	pTrack = NULL;
+	pStrings = NULL;
+	pState = NULL;
+	pStats = NULL;
+	pReaders = NULL;
+	pSchema = NULL;
+	telemetryCount = 0;
+	graphicsCount = 0;
+	pBuf = (rfShared*)rfMapCreate(bufMap, tag, sizeof(rfShared));
 	if (pBuf == NULL) {
-		// failed to map memory buffer
-		CloseHandle(hMap);
-		mapped = FALSE;
+		mapped = false;
 		return;
 	}
-	mapped = TRUE;
+	mapped = true;
 	if (mapped) {
-		memset(pBuf, 0, sizeof(rfShared));
+		// carry on from an existing sequence so attached readers see a change
+		sequence = pBuf->sequence & ~1U;
+		BeginUpdate();
+		ClearBuffer();
 		strcpy(pBuf->version, RF_SHARED_MEMORY_VERSION);
+		EndUpdate();
+	}
+	ForgetVehicles();
+	// the wakeup counters live in the main map's reader line
+	char signalTag[256] = {};
+	rfMapName(signalTag, sizeof(signalTag), RF_SHARED_MEMORY_TELEMETRY_SIGNAL_NAME);
+	rfSignalOpen(telemetrySignal, signalTag, &pBuf->telemetrySignal, &pBuf->telemetryWaiters);
+	rfMapName(signalTag, sizeof(signalTag), RF_SHARED_MEMORY_SCORING_SIGNAL_NAME);
+	rfSignalOpen(scoringSignal, signalTag, &pBuf->scoringSignal, &pBuf->scoringWaiters);
+	// history is optional, the main map works without it
+	pHistory = (rfHistory*)rfMapCreate(historyMap, historyTag, sizeof(rfHistory));
+	if (pHistory) {
+		strcpy(pHistory->version, RF_SHARED_MEMORY_VERSION);
+		pHistory->capacity = RF_SHARED_MEMORY_HISTORY_SIZE;
+		// keep numbering frames from where an attached reader's cursor is
+		telemetryCount = pHistory->head;
+	}
+	// so are the per-consumer segments and the raw scoring state
+	pTelemetry = MapSegment<rfTelemetrySegment>(telemetryMap, RF_SHARED_MEMORY_TELEMETRY_NAME, telemetrySequence);
+	pScoring = MapSegment<rfScoringSegment>(scoringMap, RF_SHARED_MEMORY_SCORING_NAME, scoringSequence);
+	// the vehicle segment is only as long as the configured field
+	vehicleCapacity = VehicleCapacity();
+	// the main map still gets all its entries when the segment is smaller
+	trackedVehicles = vehicleCapacity > RF_SHARED_MEMORY_MAX_VSI_SIZE ? vehicleCapacity : RF_SHARED_MEMORY_MAX_VSI_SIZE;
+	pVehicles = MapSegment<rfVehicleSegment>(vehiclesMap, RF_SHARED_MEMORY_VEHICLES_NAME, vehiclesSequence, RF_SHARED_MEMORY_VEHICLES_SIZE(vehicleCapacity));
+	if (pVehicles) {
+		SeqBegin(pVehicles->sequence, vehiclesSequence);
+		pVehicles->capacity = vehicleCapacity;
+		SeqEnd(pVehicles->sequence, vehiclesSequence);
+	} else {
+		// most likely a reader created it too small before we started (Windows only)
+		rfLog("running without %s for %d vehicles", RF_SHARED_MEMORY_VEHICLES_NAME, vehicleCapacity);
+	}
+	pSession = MapSegment<rfSessionSegment>(sessionMap, RF_SHARED_MEMORY_SESSION_NAME, sessionSequence);
+	pGraphics = MapSegment<rfGraphicsSegment>(graphicsMap, RF_SHARED_MEMORY_GRAPHICS_NAME, graphicsSequence);
+	pTrack = MapSegment<rfTrackSegment>(trackMap, RF_SHARED_MEMORY_TRACK_NAME, trackSequence);
+	// ids are only good for the life of the plugin, so the string table starts over
+	pStrings = MapSegment<rfStringTable>(stringsMap, RF_SHARED_MEMORY_STRINGS_NAME, stringsSequence);
+	if (pStrings) {
+		SeqBegin(pStrings->sequence, stringsSequence);
+		strings.Reset(*pStrings);
+		SeqEnd(pStrings->sequence, stringsSequence);
+	}
+	pState = MapSegment<rfScoringState>(stateMap, RF_SHARED_MEMORY_SCORING_STATE_NAME, stateSequence);
+	// and the instrumentation, counted from zero for every plugin instance
+	pStats = MapSegment<rfStats>(statsMap, RF_SHARED_MEMORY_STATS_NAME, statsSequence);
+	if (pStats) {
+		SeqBegin(pStats->sequence, statsSequence);
+		pStats->numProbes = probeCount;
+		pStats->vehiclesUnmapped = (pVehicles == NULL);
+		SeqEnd(pStats->sequence, statsSequence);
+		statsStartCycles = rfCycles();
+		statsStartTime = rfClockSeconds();
+	}
+	// readers may have registered before we got here, so only the header is ours
+	char readersTag[256] = {};
+	rfMapName(readersTag, sizeof(readersTag), RF_SHARED_MEMORY_READERS_NAME);
+	pReaders = (rfReaderTable*)rfMapCreate(readersMap, readersTag, sizeof(rfReaderTable));
+	if (pReaders) {
+		strcpy(pReaders->version, RF_SHARED_MEMORY_VERSION);
+		pReaders->numSlots = RF_SHARED_MEMORY_MAX_READERS;
+		pReaders->head = telemetryCount;
+	}
+	// field descriptors for generic readers, fixed for the life of the plugin
+	pSchema = MapSegment<rfSchema>(schemaMap, RF_SHARED_MEMORY_SCHEMA_NAME, schemaSequence);
+	if (pSchema) {
+		SeqBegin(pSchema->sequence, schemaSequence);
+		rfSchemaFill(*pSchema);
+		SeqEnd(pSchema->sequence, schemaSequence);
 	}
 	return;
 }
 
 void SharedMemoryMapPlugin::Shutdown() {
+	recorder.Stop();
+	track.Save(TrackDir());
+	track.Stop();
 	// release buffer and close handle
 	if (mapped) {
-		memset(pBuf, 0, sizeof(rfShared));
-	}
-	if (pBuf) {
-		UnmapViewOfFile(pBuf);
+		BeginUpdate();
+		ClearBuffer();
+		EndUpdate();
+		// let blocked readers notice the plugin went away
+		rfSignalNotify(telemetrySignal);
+		rfSignalNotify(scoringSignal);
+		rfSignalClose(telemetrySignal);
+		rfSignalClose(scoringSignal);
 	}
-	if (hMap) {
-		CloseHandle(hMap);
-	}
-	mapped = FALSE;
+	rfMapClose(bufMap);
+	rfMapClose(historyMap);
+	rfMapClose(telemetryMap);
+	rfMapClose(scoringMap);
+	rfMapClose(vehiclesMap);
+	rfMapClose(sessionMap);
+	rfMapClose(graphicsMap);
+	rfMapClose(trackMap);
+	rfMapClose(stringsMap);
+	rfMapClose(stateMap);
+	rfMapClose(statsMap);
+	rfMapClose(readersMap);
+	rfMapClose(schemaMap);
+	pBuf = NULL;
+	pHistory = NULL;
+	pTelemetry = NULL;
+	pScoring = NULL;
+	pVehicles = NULL;
+	pSession = NULL;
+	pGraphics = NULL;
+	pTrack = NULL;
+	pStrings = NULL;
+	pState = NULL;
+	pStats = NULL;
+	pReaders = NULL;
+	pSchema = NULL;
+	mapped = false;
 }
 
 void SharedMemoryMapPlugin::StartSession() {
-	// zero-out buffer at start of session
+	ResetSession();
+	StartRecording();
+	recorder.Record(captureStartSession);
+}
+
+void SharedMemoryMapPlugin::EndSession() {
+	recorder.Record(captureEndSession);
+	recorder.Stop();
+	track.Save(TrackDir());
+	ResetSession();
+}
+
+void SharedMemoryMapPlugin::EnterRealtime() {
+	recorder.Record(captureEnterRealtime);
+	inRealtime = true;
+}
+
+void SharedMemoryMapPlugin::ExitRealtime() {
+	recorder.Record(captureExitRealtime);
+	inRealtime = false;
+}
+
+void SharedMemoryMapPlugin::ResetSession() {
+	// zero-out buffer at start and end of session
 	if (mapped) {
-		memset(pBuf, 0, sizeof(rfShared));
+		BeginUpdate();
+		ClearBuffer();
 		strcpy(pBuf->version, RF_SHARED_MEMORY_VERSION);
+		EndUpdate();
+	}
+	if (pTelemetry) {
+		ClearSegment(pTelemetry, telemetrySequence);
+	}
+	if (pScoring) {
+		ClearSegment(pScoring, scoringSequence);
+	}
+	if (pVehicles) {
+		ClearSegment(pVehicles, vehiclesSequence, RF_SHARED_MEMORY_VEHICLES_SIZE(vehicleCapacity));
+		SeqBegin(pVehicles->sequence, vehiclesSequence);
+		pVehicles->capacity = vehicleCapacity;
+		SeqEnd(pVehicles->sequence, vehiclesSequence);
+	}
+	if (pSession) {
+		ClearSegment(pSession, sessionSequence);
 	}
-	cLastScoringUpdate = 0;
 	cDelta = 0;
+	interpolationRequested = false;
 	scoring = { 0 };
+	gaps.Reset();
+	standings.Reset();
+	ForgetVehicles();
 }
 
-void SharedMemoryMapPlugin::EndSession() {
-	// zero-out buffer at end of session
-	StartSession();
+void SharedMemoryMapPlugin::ForgetVehicles() {
+	memset(published, 0, sizeof(published));
+	memset(changedVehicles, 0, sizeof(changedVehicles));
+	publishedVehicles = 0;
+	vehiclesInterpolated = false;
+	scoringGeneration = 0;
 }
 
-void SharedMemoryMapPlugin::EnterRealtime() {
-	inRealtime = TRUE;
+void SharedMemoryMapPlugin::StartRecording() {
+	const char *dir = getenv(PLUGIN_RECORD_DIR_VAR);
+	if (dir == NULL || dir[0] == 0) {
+		return;
+	}
+	char stamp[32] = {};
+	time_t now = time(NULL);
+	strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", localtime(&now));
+	// a session restarted within the same second gets a suffix rather than
+	// overwriting the last one's capture
+	char path[1024] = {};
+	snprintf(path, sizeof(path), "%s/rfSession-%s.rfcap", dir, stamp);
+	for (int i = 2; !recorder.Start(path) && i <= PLUGIN_RECORD_MAX_SUFFIX; i++) {
+		snprintf(path, sizeof(path), "%s/rfSession-%s-%d.rfcap", dir, stamp, i);
+	}
 }
 
-void SharedMemoryMapPlugin::ExitRealtime() {
-	inRealtime = FALSE;
+void SharedMemoryMapPlugin::BeginUpdate() {
+	SeqBegin(pBuf->sequence, sequence);
+}
+
+void SharedMemoryMapPlugin::EndUpdate() {
+	SeqEnd(pBuf->sequence, sequence);
+}
+
+void SharedMemoryMapPlugin::ClearBuffer() {
+	// the sequence must never drop back to an even value mid-update, and
+	// the reader line (flags and wakeup counters) is shared with the readers
+	char *buf = (char*)pBuf;
+	size_t afterSequence = offsetof(rfShared, sequence) + sizeof(pBuf->sequence);
+	size_t afterReaders = offsetof(rfShared, telemetryTime);
+	memset(buf, 0, offsetof(rfShared, sequence));
+	memset(buf + afterSequence, 0, offsetof(rfShared, readerFlags) - afterSequence);
+	memset(buf + afterReaders, 0, sizeof(rfShared) - afterReaders);
+}
+
+bool SharedMemoryMapPlugin::InterpolationWanted() {
+	// readers renew their flags on every poll; take them and clear the word
+	// so flags from readers that went away expire
+	volatile uint32_t *readerFlags = &pBuf->readerFlags;
+	if (*readerFlags != 0) {
+		uint32_t flags = rfAtomicExchange(readerFlags, 0);
+		if (flags & readerVehicleInterpolation) {
+			lastInterpolationRequest = rfClockSeconds();
+			interpolationRequested = true;
+		}
+	}
+	if (interpolationRequested && rfClockSeconds() - lastInterpolationRequest > RF_SHARED_MEMORY_READER_TIMEOUT) {
+		interpolationRequested = false;
+	}
+	return interpolationRequested;
+}
+
+void SharedMemoryMapPlugin::RecordLatency(rfStatsProbe probe, unsigned long long cycles) {
+	if (pStats == NULL) {
+		return;
+	}
+	int b = rfLog2(cycles);
+	rfLatencyStats &s = pStats->probe[probe];
+	SeqBegin(pStats->sequence, statsSequence);
+	s.calls++;
+	s.totalCycles += cycles;
+	if (cycles > s.maxCycles) {
+		s.maxCycles = cycles;
+	}
+	s.bucket[b < RF_SHARED_MEMORY_STATS_BUCKETS ? b : RF_SHARED_MEMORY_STATS_BUCKETS - 1]++;
+	SeqEnd(pStats->sequence, statsSequence);
+}
+
+void SharedMemoryMapPlugin::RefreshStats() {
+	if (pStats == NULL) {
+		return;
+	}
+	// averaged over the plugin's lifetime, so it settles after a few updates
+	double elapsed = rfClockSeconds() - statsStartTime;
+	SeqBegin(pStats->sequence, statsSequence);
+	if (elapsed > 0.0) {
+		pStats->cyclesPerSecond = (double)(rfCycles() - statsStartCycles) / elapsed;
+	}
+	pStats->recording = recorder.Recording();
+	pStats->recordFailed = recorder.Failed();
+	pStats->recordedRecords = recorder.Records();
+	pStats->droppedRecords = recorder.Dropped();
+	pStats->recordedBytes = recorder.Written();
+	SeqEnd(pStats->sequence, statsSequence);
+}
+
+void SharedMemoryMapPlugin::TrackReaders() {
+	*(volatile uint32_t*)&pReaders->head = telemetryCount;
+	for (int i = 0; i < RF_SHARED_MEMORY_MAX_READERS; i++) {
+		rfReaderSlot *slot = &pReaders->slot[i];
+		uint32_t owner = *(volatile uint32_t*)&slot->owner;
+		// skip free slots and readers still filling theirs in
+		if (owner == 0 || *(volatile double*)&slot->heartbeat == 0.0) {
+			continue;
+		}
+		rfReaderStatus *status = &pReaders->status[i];
+		if (status->owner != owner) {
+			status->owner = owner;
+			status->lag = 0;
+			status->maxLag = 0;
+			status->overruns = 0;
+		}
+		uint32_t lag = telemetryCount - *(volatile uint32_t*)&slot->cursor;
+		if ((int32_t)lag < 0) {
+			// cursor from the future, e.g. a reader left over from an earlier plugin instance
+			lag = 0;
+		}
+		if (lag > RF_SHARED_MEMORY_HISTORY_SIZE && status->lag <= RF_SHARED_MEMORY_HISTORY_SIZE) {
+			status->overruns++;
+		}
+		status->lag = lag;
+		if (lag > status->maxLag) {
+			status->maxLag = lag;
+		}
+	}
+}
+
+void SharedMemoryMapPlugin::ExpireReaders() {
+	double now = rfClockSeconds();
+	for (int i = 0; i < RF_SHARED_MEMORY_MAX_READERS; i++) {
+		rfReaderSlot *slot = &pReaders->slot[i];
+		uint32_t owner = *(volatile uint32_t*)&slot->owner;
+		double heartbeat = *(volatile double*)&slot->heartbeat;
+		if (owner != 0 && heartbeat != 0.0 && now - heartbeat > RF_SHARED_MEMORY_READER_STALE) {
+			// the reader went away without unregistering; if it comes back it
+			// sees it lost the slot and registers again
+			*(volatile double*)&slot->heartbeat = 0.0;
+			rfAtomicCompareExchange(&slot->owner, owner, 0);
+		}
+	}
+}
+
+void SharedMemoryMapPlugin::CopyTelemetry(rfTelemetryFrame &frame) {
+	// the frame mirrors rfShared from telemetryTime to trackNameId (checked in rfSharedStruct.hpp)
+	frame.currentET = scoring.currentET + cDelta;
+	memcpy(&frame.telemetryTime, &pBuf->telemetryTime, offsetof(rfShared, trackNameId) + sizeof(pBuf->trackNameId) - offsetof(rfShared, telemetryTime));
+}
+
+void SharedMemoryMapPlugin::PublishTelemetrySegment() {
+	SeqBegin(pTelemetry->sequence, telemetrySequence);
+	pTelemetry->telemetry.sequence = telemetryCount;
+	CopyTelemetry(pTelemetry->telemetry);
+	SeqEnd(pTelemetry->sequence, telemetrySequence);
+}
+
+void SharedMemoryMapPlugin::PushHistory() {
+	uint32_t next = telemetryCount;
+	rfTelemetryFrame *slot = &pHistory->frame[(next - 1) & (RF_SHARED_MEMORY_HISTORY_SIZE - 1)];
+	// invalidate the slot so readers lapping the writer discard it
+	*(volatile uint32_t*)&slot->sequence = 0;
+	std::atomic_thread_fence(std::memory_order_release);
+	CopyTelemetry(*slot);
+	std::atomic_thread_fence(std::memory_order_release);
+	*(volatile uint32_t*)&slot->sequence = next;
+	std::atomic_thread_fence(std::memory_order_release);
+	*(volatile uint32_t*)&pHistory->head = next;
+}
+
+static void ScatterInterpolation(rfVehicleInfo *vehicle, const rfVehicleInterpSoA &interp, const rfGapEngine &gaps, int count) {
+	for (int i = 0; i < count; i++) {
+		vehicle[i].pos = { interp.pos.x[i], interp.pos.y[i], interp.pos.z[i] };
+		vehicle[i].yaw = interp.yaw[i];
+		vehicle[i].pitch = interp.pitch[i];
+		vehicle[i].roll = interp.roll[i];
+		vehicle[i].speed = interp.speed[i];
+		vehicle[i].lapDist = interp.lapDist[i];
+		vehicle[i].distanceAhead = gaps.distanceAhead[i];
+		vehicle[i].timeAhead = gaps.timeAhead[i];
+		vehicle[i].distanceBehind = gaps.distanceBehind[i];
+		vehicle[i].timeBehind = gaps.timeBehind[i];
+		vehicle[i].vehicleAhead = gaps.ahead[i];
+		vehicle[i].vehicleBehind = gaps.behind[i];
+	}
 }
 
 void SharedMemoryMapPlugin::UpdateTelemetry( const TelemInfoV2 &info ) {
+	recorder.RecordTelemetry(info);
 	if (mapped) {
-		// update clock delta
-		cDelta = (float)(clock() - cLastScoringUpdate) / (float)CLOCKS_PER_SEC;
+		unsigned long long start = rfCycles();
+
+		// time since the last scoring update on the monotonic clock
+		double now = rfClockSeconds();
+		cDelta = (float)(now - scoring.scoringTime);
+
+		BeginUpdate();
+		pBuf->telemetryTime = now;
 
 		// TelemInfoBase
 		pBuf->deltaTime = cDelta;
 		pBuf->lapNumber = info.mLapNumber;
 		pBuf->lapStartET = info.mLapStartET;
-		strcpy(pBuf->trackName, info.mTrackName);
+		// names hardly ever change, so they're only rewritten (and interned) when they do
+		if (strcmp(pBuf->trackName, info.mTrackName) != 0) {
+			strcpy(pBuf->trackName, info.mTrackName);
+			pBuf->trackNameId = Intern(info.mTrackName);
+		}
 		pBuf->pos = { info.mPos.x, info.mPos.y, info.mPos.z };
 		pBuf->localVel = { info.mLocalVel.x, info.mLocalVel.y, info.mLocalVel.z };
 		pBuf->localAccel = { info.mLocalAccel.x, info.mLocalAccel.y, info.mLocalAccel.z };
@@ -210,149 +587,246 @@ void SharedMemoryMapPlugin::UpdateTelemetry( const TelemInfoV2 &info ) {
 
 			//TelemWheelV2
 			pBuf->wheel[i].wear = info.mWheel[i].mWear;
-			strcpy(pBuf->wheel[i].terrainName, info.mWheel[i].mTerrainName);
+			if (strcmp(pBuf->wheel[i].terrainName, info.mWheel[i].mTerrainName) != 0) {
+				strcpy(pBuf->wheel[i].terrainName, info.mWheel[i].mTerrainName);
+				pBuf->wheel[i].terrainNameId = Intern(info.mWheel[i].mTerrainName);
+			}
 			pBuf->wheel[i].surfaceType = info.mWheel[i].mSurfaceType;
 			pBuf->wheel[i].flat = info.mWheel[i].mFlat;
 			pBuf->wheel[i].detached = info.mWheel[i].mDetached;
 		}
 		
 		// interpolation of scoring info
-		if (cDelta > 0.0f && cDelta < 0.55f) {
+		if (cDelta > 0.0f && cDelta < RF_SHARED_MEMORY_MAX_INTERPOLATION) {
 			// ScoringInfoBase
 			pBuf->currentET = scoring.currentET + cDelta;
 
 			// ScoringInfoV2
 			pBuf->inRealtime = inRealtime;
 
-			for (int i = 0; i < RF_SHARED_MEMORY_MAX_VSI_SIZE; i++) {
-				if (i < scoring.numVehicles) {
-					// VehicleScoringInfoV2
-					// applying 0.05x acceleration seems to help the interpolation
-					rfVec3 localRotAccel = { scoring.vehicle[i].localRotAccel.x, scoring.vehicle[i].localRotAccel.y, scoring.vehicle[i].localRotAccel.z };
-					rfVec3 localAccel = { scoring.vehicle[i].localAccel.x, scoring.vehicle[i].localAccel.y, scoring.vehicle[i].localAccel.z };
-					rfVec3 localRot = { scoring.vehicle[i].localRot.x, scoring.vehicle[i].localRot.y, scoring.vehicle[i].localRot.z };
-					rfVec3 localVel = { scoring.vehicle[i].localVel.x, scoring.vehicle[i].localVel.y, scoring.vehicle[i].localVel.z };
-					
-					localRot.x += localRotAccel.x * cDelta * RF_SHARED_MEMORY_ACC_SMOOTH_FACTOR;
-					localRot.y += localRotAccel.y * cDelta * RF_SHARED_MEMORY_ACC_SMOOTH_FACTOR;
-					localRot.z += localRotAccel.z * cDelta * RF_SHARED_MEMORY_ACC_SMOOTH_FACTOR;
-
-					localVel.x += localAccel.x * cDelta * RF_SHARED_MEMORY_ACC_SMOOTH_FACTOR;
-					localVel.y += localAccel.y * cDelta * RF_SHARED_MEMORY_ACC_SMOOTH_FACTOR;
-					localVel.z += localAccel.z * cDelta * RF_SHARED_MEMORY_ACC_SMOOTH_FACTOR;
-
-					// rotate and normalize orientation vectors (normalizing shouldn't be necessary if this is correct)
-					rfVec3 oriX = { scoring.vehicle[i].oriX.x, scoring.vehicle[i].oriX.y, scoring.vehicle[i].oriX.z };
-					rfVec3 oriY = { scoring.vehicle[i].oriY.x, scoring.vehicle[i].oriY.y, scoring.vehicle[i].oriY.z };
-					rfVec3 oriZ = { scoring.vehicle[i].oriZ.x, scoring.vehicle[i].oriZ.y, scoring.vehicle[i].oriZ.z };
-					rfVec3 wRot = { ((oriX.x * localRot.x) + (oriX.y * localRot.y) + (oriX.z * localRot.z)) * cDelta * RF_SHARED_MEMORY_ROT_SMOOTH_FACTOR,
-						((oriY.x * localRot.x) + (oriY.y * localRot.y) + (oriY.z * localRot.z)) * cDelta * RF_SHARED_MEMORY_ROT_SMOOTH_FACTOR,
-						((oriZ.x * localRot.x) + (oriZ.y * localRot.y) + (oriZ.z * localRot.z)) * cDelta * RF_SHARED_MEMORY_ROT_SMOOTH_FACTOR };
-					rfVec3 tmpX, tmpY, tmpZ;
-					float tmpLen;
-					
-					// X
-					// rotate by z
-					tmpZ.x = oriX.x * cosf(wRot.z) - oriX.y * -sinf(wRot.z);
-					tmpZ.y = oriX.x * -sinf(wRot.z) + oriX.y * cosf(wRot.z);
-					tmpZ.z = oriX.z;
-					// rotate by y
-					tmpY.x = tmpZ.x * cosf(wRot.y) + tmpZ.z * -sinf(wRot.y);
-					tmpY.y = tmpZ.y;
-					tmpY.z = tmpZ.z * cosf(wRot.y) - tmpZ.x * -sinf(wRot.y);
-					// rotate by x
-					tmpX.x = tmpY.x;
-					tmpX.y = tmpY.y * cosf(wRot.x) - tmpY.z * -sinf(wRot.x);
-					tmpX.z = tmpY.y * -sinf(wRot.x) + tmpY.z * cosf(wRot.x);
-					tmpLen = sqrtf(tmpX.x * tmpX.x + tmpX.y * tmpX.y + tmpX.z * tmpX.z);
-					if (tmpLen > 0) {
-						oriX = { tmpX.x / tmpLen, tmpX.y / tmpLen, tmpX.z / tmpLen };
-					}
-
-					// Y
-					// rotate by z
-					tmpZ.x = oriY.x * cosf(wRot.z) - oriY.y * -sinf(wRot.z);
-					tmpZ.y = oriY.x * -sinf(wRot.z) + oriY.y * cosf(wRot.z);
-					tmpZ.z = oriY.z;
-					// rotate by y
-					tmpY.x = tmpZ.x * cosf(wRot.y) + tmpZ.z * -sinf(wRot.y);
-					tmpY.y = tmpZ.y;
-					tmpY.z = tmpZ.z * cosf(wRot.y) - tmpZ.x * -sinf(wRot.y);
-					// rotate by x
-					tmpX.x = tmpY.x;
-					tmpX.y = tmpY.y * cosf(wRot.x) - tmpY.z * -sinf(wRot.x);
-					tmpX.z = tmpY.y * -sinf(wRot.x) + tmpY.z * cosf(wRot.x);
-					tmpLen = sqrtf(tmpX.x * tmpX.x + tmpX.y * tmpX.y + tmpX.z * tmpX.z);
-					if (tmpLen > 0) {
-						oriY = { tmpX.x / tmpLen, tmpX.y / tmpLen, tmpX.z / tmpLen };
-					}
-
-					// Z
-					// rotate by z
-					tmpZ.x = oriZ.x * cosf(wRot.z) - oriZ.y * -sinf(wRot.z);
-					tmpZ.y = oriZ.x * -sinf(wRot.z) + oriZ.y * cosf(wRot.z);
-					tmpZ.z = oriZ.z;
-					// rotate by y
-					tmpY.x = tmpZ.x * cosf(wRot.y) + tmpZ.z * -sinf(wRot.y);
-					tmpY.y = tmpZ.y;
-					tmpY.z = tmpZ.z * cosf(wRot.y) - tmpZ.x * -sinf(wRot.y);
-					// rotate by x
-					tmpX.x = tmpY.x;
-					tmpX.y = tmpY.y * cosf(wRot.x) - tmpY.z * -sinf(wRot.x);
-					tmpX.z = tmpY.y * -sinf(wRot.x) + tmpY.z * cosf(wRot.x);
-					tmpLen = sqrtf(tmpX.x * tmpX.x + tmpX.y * tmpX.y + tmpX.z * tmpX.z);
-					if (tmpLen > 0) {
-						oriZ = { tmpX.x / tmpLen, tmpX.y / tmpLen, tmpX.z / tmpLen };
-					}
-					
-					// position
-					rfVec3 pos = { scoring.vehicle[i].pos.x, scoring.vehicle[i].pos.y, scoring.vehicle[i].pos.z };
-					pos.x += ((oriX.x * localVel.x) + (oriX.y * localVel.y) + (oriX.z * localVel.z)) * cDelta;
-					pos.y += ((oriY.x * localVel.x) + (oriY.y * localVel.y) + (oriY.z * localVel.z)) * cDelta;
-					pos.z += ((oriZ.x * localVel.x) + (oriZ.y * localVel.y) + (oriZ.z * localVel.z)) * cDelta;
-					pBuf->vehicle[i].pos = { pos.x, pos.y, pos.z };
-
-					pBuf->vehicle[i].yaw = atan2f(oriZ.x, oriZ.z);
-					pBuf->vehicle[i].pitch = atan2f(-oriY.z, sqrtf(oriX.z * oriX.z + oriZ.z * oriZ.z));
-					pBuf->vehicle[i].roll = atan2f(oriY.x, sqrtf(oriX.x * oriX.x + oriZ.x * oriZ.x));
-
-					// interpolate speed
-					pBuf->vehicle[i].speed = sqrtf((localVel.x * localVel.x) + (localVel.y * localVel.y) + (localVel.z * localVel.z));
-
-					// VehicleScoringInfo
-					pBuf->vehicle[i].lapDist = scoring.vehicle[i].lapDist - localVel.z * cDelta;
-
-					continue;
+			// VehicleScoringInfoV2, skipped entirely while no reader wants it
+			if (InterpolationWanted()) {
+				unsigned long long interpStart = rfCycles();
+				int count = scoring.numVehicles < trackedVehicles ? scoring.numVehicles : trackedVehicles;
+				interpolate(scoring.vehicle, count, cDelta, interp);
+				gaps.Update(interp.lapDist, interp.speed, count, scoring.lapLength, scoring.currentET + cDelta);
+				ScatterInterpolation(pBuf->vehicle, interp, gaps, count < RF_SHARED_MEMORY_MAX_VSI_SIZE ? count : RF_SHARED_MEMORY_MAX_VSI_SIZE);
+				vehiclesInterpolated = true;
+				if (pVehicles) {
+					SeqBegin(pVehicles->sequence, vehiclesSequence);
+					pVehicles->currentET = scoring.currentET + cDelta;
+					ScatterInterpolation(pVehicles->vehicle, interp, gaps, count < vehicleCapacity ? count : vehicleCapacity);
+					SeqEnd(pVehicles->sequence, vehiclesSequence);
 				}
+				RecordLatency(probeInterpolation, rfCycles() - interpStart);
 			}
 		}
+		EndUpdate();
+
+		telemetryCount++;
+		if (pTelemetry) {
+			PublishTelemetrySegment();
+		}
+		if (pHistory) {
+			PushHistory();
+		}
+		if (pReaders) {
+			TrackReaders();
+		}
+		// wake blocked readers once everything for this frame is out
+		rfSignalNotify(telemetrySignal);
+		RecordLatency(probeTelemetry, rfCycles() - start);
+	}
+}
+
+void SharedMemoryMapPlugin::UpdateGraphics( const GraphicsInfoV2 &info ) {
+	// called once per rendered frame, possibly from the render thread: nothing
+	// but this segment is touched (not even the recorder), and it isn't cleared
+	// between sessions so it never has a second writer
+	if (pGraphics == NULL) {
+		return;
+	}
+	SeqBegin(pGraphics->sequence, graphicsSequence);
+	pGraphics->frames = ++graphicsCount;
+	pGraphics->graphicsTime = rfClockSeconds();
+	pGraphics->camPos = { info.mCamPos.x, info.mCamPos.y, info.mCamPos.z };
+	pGraphics->camOri = { info.mCamOri.x, info.mCamOri.y, info.mCamOri.z };
+	pGraphics->ambientRed = info.mAmbientRed;
+	pGraphics->ambientGreen = info.mAmbientGreen;
+	pGraphics->ambientBlue = info.mAmbientBlue;
+	SeqEnd(pGraphics->sequence, graphicsSequence);
+}
+
+void SharedMemoryMapPlugin::PublishScoringState() {
+	SeqBegin(pState->sequence, stateSequence);
+	pState->numVehicles = scoring.numVehicles < vehicleCapacity ? scoring.numVehicles : vehicleCapacity;
+	pState->scoringTime = scoring.scoringTime;
+	pState->currentET = scoring.currentET;
+	// the state is all float arrays, each copied only up to the capacity
+	const float *src = (const float*)&scoring.vehicle;
+	float *dst = (float*)&pState->vehicle;
+	for (size_t a = 0; a < sizeof(rfVehicleStateSoA) / sizeof(scoring.vehicle.lapDist); a++) {
+		memcpy(dst + a * RF_SHARED_MEMORY_MAX_VEHICLES, src + a * RF_SHARED_MEMORY_MAX_VEHICLES, vehicleCapacity * sizeof(float));
+	}
+	SeqEnd(pState->sequence, stateSequence);
+}
+
+// write through the cache lines of a vehicle that differ from what was last
+// written; the interpolated values share the first line with the gaps, which
+// only telemetry writes, so those are compared field by field, and always
+// rewritten once telemetry has interpolated over them
+static const size_t interpolatedSize = offsetof(rfVehicleInfo, distanceAhead) - offsetof(rfVehicleInfo, pos);
+
+static void WriteVehicle(rfVehicleInfo &dst, const rfVehicleInfo &last, const rfVehicleInfo &v, bool interpolated) {
+	if (interpolated || memcmp(&v.pos, &last.pos, interpolatedSize) != 0) {
+		memcpy(&dst.pos, &v.pos, interpolatedSize);
+	}
+	for (size_t line = RF_SHARED_MEMORY_CACHE_LINE; line < sizeof(rfVehicleInfo); line += RF_SHARED_MEMORY_CACHE_LINE) {
+		if (memcmp((const char*)&v + line, (const char*)&last + line, RF_SHARED_MEMORY_CACHE_LINE) != 0) {
+			memcpy((char*)&dst + line, (const char*)&v + line, RF_SHARED_MEMORY_CACHE_LINE);
+		}
 	}
 }
 
+// the same for an entry known to have changed
+static void CopyScoring(rfVehicleInfo &dst, const rfVehicleInfo &v) {
+	memcpy(&dst.pos, &v.pos, interpolatedSize);
+	memcpy(&dst.driverName, &v.driverName, sizeof(rfVehicleInfo) - offsetof(rfVehicleInfo, driverName));
+}
+
+void SharedMemoryMapPlugin::PublishScoringSegments(const ScoringInfoV2 &info) {
+	if (pScoring) {
+		SeqBegin(pScoring->sequence, scoringSequence);
+		pScoring->scoringTime = pBuf->scoringTime;
+		pScoring->currentET = pBuf->scoringET;
+		pScoring->session = pBuf->session;
+		pScoring->endET = pBuf->endET;
+		pScoring->maxLaps = pBuf->maxLaps;
+		pScoring->lapDist = pBuf->lapDist;
+		pScoring->numVehicles = pBuf->numVehicles;
+		pScoring->gamePhase = pBuf->gamePhase;
+		pScoring->yellowFlagState = pBuf->yellowFlagState;
+		memcpy(pScoring->sectorFlag, pBuf->sectorFlag, sizeof(pScoring->sectorFlag));
+		pScoring->startLight = pBuf->startLight;
+		pScoring->numRedLights = pBuf->numRedLights;
+		pScoring->inRealtime = pBuf->inRealtime;
+		pScoring->ambientTemp = pBuf->ambientTemp;
+		pScoring->trackTemp = pBuf->trackTemp;
+		pScoring->wind = pBuf->wind;
+		SeqEnd(pScoring->sequence, scoringSequence);
+	}
+	if (pVehicles) {
+		SeqBegin(pVehicles->sequence, vehiclesSequence);
+		pVehicles->numVehicles = publishedVehicles < vehicleCapacity ? publishedVehicles : vehicleCapacity;
+		pVehicles->scoringTime = pBuf->scoringTime;
+		pVehicles->currentET = pBuf->scoringET;
+		pVehicles->scoringGeneration = pBuf->scoringGeneration;
+		memcpy(pVehicles->changedVehicles, changedVehicles, sizeof(pVehicles->changedVehicles));
+		for (int i = 0; i < vehicleCapacity; i++) {
+			if ((changedVehicles[i / 64] & (1ULL << (i % 64))) == 0) {
+				if (vehiclesInterpolated && i < publishedVehicles) {
+					memcpy(&pVehicles->vehicle[i].pos, &published[i].pos, interpolatedSize);
+				}
+				continue;
+			}
+			if (i < publishedVehicles) {
+				CopyScoring(pVehicles->vehicle[i], published[i]);
+			} else {
+				pVehicles->vehicle[i] = { 0 };
+			}
+		}
+		if (pVehicles->standings.generation != pBuf->standings.generation) {
+			pVehicles->standings = pBuf->standings;
+		}
+		SeqEnd(pVehicles->sequence, vehiclesSequence);
+	}
+	// names hardly ever change, so the session segment's sequence only moves when they do
+	if (pSession && (strcmp(pSession->trackName, info.mTrackName) != 0 ||
+		strcmp(pSession->playerName, info.mPlayerName) != 0 || strcmp(pSession->plrFileName, info.mPlrFileName) != 0)) {
+		SeqBegin(pSession->sequence, sessionSequence);
+		strcpy(pSession->trackName, info.mTrackName);
+		strcpy(pSession->playerName, info.mPlayerName);
+		strcpy(pSession->plrFileName, info.mPlrFileName);
+		SeqEnd(pSession->sequence, sessionSequence);
+	}
+}
+
+uint16_t SharedMemoryMapPlugin::Intern(const char *s) {
+	if (pStrings == NULL || s[0] == 0) {
+		return 0;
+	}
+	uint16_t id = strings.Find(*pStrings, s);
+	if (id == 0) {
+		SeqBegin(pStrings->sequence, stringsSequence);
+		id = strings.Add(*pStrings, s);
+		SeqEnd(pStrings->sequence, stringsSequence);
+	}
+	return id;
+}
+
+void SharedMemoryMapPlugin::LearnTrack(const ScoringInfoV2 &info) {
+	if (!track.Matches(info.mTrackName, info.mLapDist)) {
+		track.Reset(info.mTrackName, info.mLapDist, TrackDir());
+	}
+	for (int i = 0; i < publishedVehicles; i++) {
+		// pit lanes and cars parked on track would drag the line off the racing surface
+		const VehicleScoringInfoV2 &v = info.mVehicle[i];
+		if (v.mInPits || published[i].speed < 1.0f) {
+			continue;
+		}
+		track.Add(v.mLapDist, published[i].pos);
+	}
+	SeqBegin(pTrack->sequence, trackSequence);
+	track.Flush(*pTrack);
+	SeqEnd(pTrack->sequence, trackSequence);
+}
+
+static inline void SetSoA(rfVec3SoA &soa, int i, const TelemVect3 &v) {
+	soa.x[i] = v.x;
+	soa.y[i] = v.y;
+	soa.z[i] = v.z;
+}
+
 void SharedMemoryMapPlugin::UpdateScoring( const ScoringInfoV2 &info ) {
+	recorder.RecordScoring(info);
 	if (mapped) {
-		cLastScoringUpdate = clock();
+		unsigned long long start = rfCycles();
+		double now = rfClockSeconds();
 
+		BeginUpdate();
 		pBuf->deltaTime = 0;
+		pBuf->scoringTime = now;
+		pBuf->scoringET = info.mCurrentET;
 
 		// update internal state
+		scoring.scoringTime = now;
 		scoring.currentET = info.mCurrentET;
+		scoring.lapLength = info.mLapDist;
 		scoring.numVehicles = info.mNumVehicles;
 		strcpy(scoring.plrFileName, info.mPlrFileName);
-		for (int i = 0; i < RF_SHARED_MEMORY_MAX_VSI_SIZE; i++) {
+		const TelemVect3 zero = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < trackedVehicles; i++) {
 			if (i < scoring.numVehicles) {
-				scoring.vehicle[i].lapDist = info.mVehicle[i].mLapDist;
-				scoring.vehicle[i].localAccel = { info.mVehicle[i].mLocalAccel.x, info.mVehicle[i].mLocalAccel.y, info.mVehicle[i].mLocalAccel.z };
-				scoring.vehicle[i].localRot = { info.mVehicle[i].mLocalRot.x, info.mVehicle[i].mLocalRot.y, info.mVehicle[i].mLocalRot.z };
-				scoring.vehicle[i].localRotAccel = { info.mVehicle[i].mLocalRotAccel.x, info.mVehicle[i].mLocalRotAccel.y, info.mVehicle[i].mLocalRotAccel.z };
-				scoring.vehicle[i].localVel = { info.mVehicle[i].mLocalVel.x, info.mVehicle[i].mLocalVel.y, info.mVehicle[i].mLocalVel.z };
-				scoring.vehicle[i].oriX = { info.mVehicle[i].mOriX.x, info.mVehicle[i].mOriX.y, info.mVehicle[i].mOriX.z };
-				scoring.vehicle[i].oriY = { info.mVehicle[i].mOriY.x, info.mVehicle[i].mOriY.y, info.mVehicle[i].mOriY.z };
-				scoring.vehicle[i].oriZ = { info.mVehicle[i].mOriZ.x, info.mVehicle[i].mOriZ.y, info.mVehicle[i].mOriZ.z };
-				scoring.vehicle[i].pos = { info.mVehicle[i].mPos.x, info.mVehicle[i].mPos.y, info.mVehicle[i].mPos.z };
+				scoring.vehicle.lapDist[i] = info.mVehicle[i].mLapDist;
+				SetSoA(scoring.vehicle.localAccel, i, info.mVehicle[i].mLocalAccel);
+				SetSoA(scoring.vehicle.localRot, i, info.mVehicle[i].mLocalRot);
+				SetSoA(scoring.vehicle.localRotAccel, i, info.mVehicle[i].mLocalRotAccel);
+				SetSoA(scoring.vehicle.localVel, i, info.mVehicle[i].mLocalVel);
+				SetSoA(scoring.vehicle.oriX, i, info.mVehicle[i].mOriX);
+				SetSoA(scoring.vehicle.oriY, i, info.mVehicle[i].mOriY);
+				SetSoA(scoring.vehicle.oriZ, i, info.mVehicle[i].mOriZ);
+				SetSoA(scoring.vehicle.pos, i, info.mVehicle[i].mPos);
 				continue;
 			}
-			scoring.vehicle[i] = { 0 };
+			scoring.vehicle.lapDist[i] = 0.0f;
+			SetSoA(scoring.vehicle.localAccel, i, zero);
+			SetSoA(scoring.vehicle.localRot, i, zero);
+			SetSoA(scoring.vehicle.localRotAccel, i, zero);
+			SetSoA(scoring.vehicle.localVel, i, zero);
+			SetSoA(scoring.vehicle.oriX, i, zero);
+			SetSoA(scoring.vehicle.oriY, i, zero);
+			SetSoA(scoring.vehicle.oriZ, i, zero);
+			SetSoA(scoring.vehicle.pos, i, zero);
 		}
 
 		// ScoringInfoBase
@@ -377,52 +851,106 @@ void SharedMemoryMapPlugin::UpdateScoring( const ScoringInfoV2 &info ) {
 		pBuf->trackTemp = info.mTrackTemp;
 		pBuf->wind = { info.mWind.x, info.mWind.y, info.mWind.z };
 
-		for (int i = 0; i < RF_SHARED_MEMORY_MAX_VSI_SIZE; i++) {
-			if (i < info.mNumVehicles) {
+		// vehicles are filled in from the last ones published and only written
+		// through to the map where they differ, so readers can skip the rest
+		// vehicles past the main map's array are only published in the vehicle segment,
+		// and those past the segment's capacity only in the main map
+		int count = info.mNumVehicles < trackedVehicles ? info.mNumVehicles : trackedVehicles;
+		int slots = count > publishedVehicles ? count : publishedVehicles;
+		memset(changedVehicles, 0, sizeof(changedVehicles));
+		scoringGeneration++;
+		for (int i = 0; i < slots; i++) {
+			if (i < count) {
+				rfVehicleInfo v = published[i];
+
 				// VehicleScoringInfo
-				strcpy(pBuf->vehicle[i].driverName, info.mVehicle[i].mDriverName);
-				pBuf->vehicle[i].totalLaps = info.mVehicle[i].mTotalLaps;
-				pBuf->vehicle[i].sector = info.mVehicle[i].mSector;
-				pBuf->vehicle[i].finishStatus = info.mVehicle[i].mFinishStatus;
-				pBuf->vehicle[i].lapDist = info.mVehicle[i].mLapDist;
-				pBuf->vehicle[i].pathLateral = info.mVehicle[i].mPathLateral;
-				pBuf->vehicle[i].trackEdge = info.mVehicle[i].mTrackEdge;
-				pBuf->vehicle[i].bestSector1 = info.mVehicle[i].mBestSector1;
-				pBuf->vehicle[i].bestSector2 = info.mVehicle[i].mBestSector2;
-				pBuf->vehicle[i].bestLapTime = info.mVehicle[i].mBestLapTime;
-				pBuf->vehicle[i].lastSector1 = info.mVehicle[i].mLastSector1;
-				pBuf->vehicle[i].lastSector2 = info.mVehicle[i].mLastSector2;
-				pBuf->vehicle[i].lastLapTime = info.mVehicle[i].mLastLapTime;
-				pBuf->vehicle[i].curSector1 = info.mVehicle[i].mCurSector1;
-				pBuf->vehicle[i].curSector2 = info.mVehicle[i].mCurSector2;
-				pBuf->vehicle[i].numPitstops = info.mVehicle[i].mNumPitstops;
-				pBuf->vehicle[i].numPenalties = info.mVehicle[i].mNumPenalties;
+				if (strcmp(v.driverName, info.mVehicle[i].mDriverName) != 0) {
+					strcpy(v.driverName, info.mVehicle[i].mDriverName);
+					v.driverNameId = Intern(info.mVehicle[i].mDriverName);
+				}
+				v.totalLaps = info.mVehicle[i].mTotalLaps;
+				v.sector = info.mVehicle[i].mSector;
+				v.finishStatus = info.mVehicle[i].mFinishStatus;
+				v.lapDist = info.mVehicle[i].mLapDist;
+				v.pathLateral = info.mVehicle[i].mPathLateral;
+				v.trackEdge = info.mVehicle[i].mTrackEdge;
+				v.bestSector1 = info.mVehicle[i].mBestSector1;
+				v.bestSector2 = info.mVehicle[i].mBestSector2;
+				v.bestLapTime = info.mVehicle[i].mBestLapTime;
+				v.lastSector1 = info.mVehicle[i].mLastSector1;
+				v.lastSector2 = info.mVehicle[i].mLastSector2;
+				v.lastLapTime = info.mVehicle[i].mLastLapTime;
+				v.curSector1 = info.mVehicle[i].mCurSector1;
+				v.curSector2 = info.mVehicle[i].mCurSector2;
+				v.numPitstops = info.mVehicle[i].mNumPitstops;
+				v.numPenalties = info.mVehicle[i].mNumPenalties;
 
 				// VehicleScoringInfoV2
-				pBuf->vehicle[i].isPlayer = info.mVehicle[i].mIsPlayer;
-				pBuf->vehicle[i].control = info.mVehicle[i].mControl;
-				pBuf->vehicle[i].inPits = info.mVehicle[i].mInPits;
-				pBuf->vehicle[i].place = info.mVehicle[i].mPlace;
-				strcpy(pBuf->vehicle[i].vehicleClass, info.mVehicle[i].mVehicleClass);
-				pBuf->vehicle[i].timeBehindNext = info.mVehicle[i].mTimeBehindNext;
-				pBuf->vehicle[i].lapsBehindNext = info.mVehicle[i].mLapsBehindNext;
-				pBuf->vehicle[i].timeBehindLeader = info.mVehicle[i].mTimeBehindLeader;
-				pBuf->vehicle[i].lapsBehindLeader = info.mVehicle[i].mLapsBehindLeader;
-				pBuf->vehicle[i].lapStartET = info.mVehicle[i].mLapStartET;
-				pBuf->vehicle[i].pos = { info.mVehicle[i].mPos.x, info.mVehicle[i].mPos.y, info.mVehicle[i].mPos.z };
-				pBuf->vehicle[i].yaw = atan2f(info.mVehicle[i].mOriZ.x, info.mVehicle[i].mOriZ.z);
-				pBuf->vehicle[i].pitch = atan2f(-info.mVehicle[i].mOriY.z, 
+				v.isPlayer = info.mVehicle[i].mIsPlayer;
+				v.control = info.mVehicle[i].mControl;
+				v.inPits = info.mVehicle[i].mInPits;
+				v.place = info.mVehicle[i].mPlace;
+				if (strcmp(v.vehicleClass, info.mVehicle[i].mVehicleClass) != 0) {
+					strcpy(v.vehicleClass, info.mVehicle[i].mVehicleClass);
+					v.vehicleClassNameId = Intern(info.mVehicle[i].mVehicleClass);
+				}
+				v.timeBehindNext = info.mVehicle[i].mTimeBehindNext;
+				v.lapsBehindNext = info.mVehicle[i].mLapsBehindNext;
+				v.timeBehindLeader = info.mVehicle[i].mTimeBehindLeader;
+				v.lapsBehindLeader = info.mVehicle[i].mLapsBehindLeader;
+				v.lapStartET = info.mVehicle[i].mLapStartET;
+				v.pos = { info.mVehicle[i].mPos.x, info.mVehicle[i].mPos.y, info.mVehicle[i].mPos.z };
+				v.yaw = atan2f(info.mVehicle[i].mOriZ.x, info.mVehicle[i].mOriZ.z);
+				v.pitch = atan2f(-info.mVehicle[i].mOriY.z, 
 					sqrtf(info.mVehicle[i].mOriX.z * info.mVehicle[i].mOriX.z + 
 						info.mVehicle[i].mOriZ.z * info.mVehicle[i].mOriZ.z));
-				pBuf->vehicle[i].roll = atan2f(info.mVehicle[i].mOriY.x, 
+				v.roll = atan2f(info.mVehicle[i].mOriY.x, 
 					sqrtf(info.mVehicle[i].mOriX.x * info.mVehicle[i].mOriX.x + 
 						info.mVehicle[i].mOriZ.x * info.mVehicle[i].mOriZ.x));
-				pBuf->vehicle[i].speed = sqrtf((info.mVehicle[i].mLocalVel.x * info.mVehicle[i].mLocalVel.x) +
+				v.speed = sqrtf((info.mVehicle[i].mLocalVel.x * info.mVehicle[i].mLocalVel.x) +
 					(info.mVehicle[i].mLocalVel.y * info.mVehicle[i].mLocalVel.y) +
 					(info.mVehicle[i].mLocalVel.z * info.mVehicle[i].mLocalVel.z));
+
+				bool changed = memcmp(&v, &published[i], sizeof(v)) != 0;
+				if (changed) {
+					v.generation = scoringGeneration;
+				}
+				// raw values go back in while deltaTime is 0, even if scoring didn't change them
+				if ((changed || vehiclesInterpolated) && i < RF_SHARED_MEMORY_MAX_VSI_SIZE) {
+					WriteVehicle(pBuf->vehicle[i], published[i], v, vehiclesInterpolated);
+				}
+				if (changed) {
+					published[i] = v;
+					changedVehicles[i / 64] |= 1ULL << (i % 64);
+				}
 				continue;
 			}
-			pBuf->vehicle[i] = { 0 };
+			// slots left by vehicles that went away are cleared once
+			if (i < RF_SHARED_MEMORY_MAX_VSI_SIZE) {
+				pBuf->vehicle[i] = { 0 };
+			}
+			published[i] = { 0 };
+			changedVehicles[i / 64] |= 1ULL << (i % 64);
+		}
+		publishedVehicles = count;
+		pBuf->scoringGeneration = scoringGeneration;
+		pBuf->changedVehicles = changedVehicles[0];
+		standings.Update(published, count, pBuf->standings);
+		EndUpdate();
+
+		PublishScoringSegments(info);
+		vehiclesInterpolated = false;
+		if (pState) {
+			PublishScoringState();
+		}
+		if (pTrack) {
+			LearnTrack(info);
+		}
+		rfSignalNotify(scoringSignal);
+		RecordLatency(probeScoring, rfCycles() - start);
+		RefreshStats();
+		if (pReaders) {
+			ExpireReaders();
 		}
 	}
 }
@@ -0,0 +1,401 @@
+/*
+ rfArchive.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Seekable recording container, see rfArchive.hpp.
+*/
+
+#include "rfArchive.hpp"
+#include "rfPlatform.hpp"
+#include <string.h>
+#include <algorithm>
+
+#define RUN_MAX 0xFFFF
+
+#pragma pack(push, 1)
+struct archiveRun {
+  unsigned short skip;          // unchanged bytes before this run
+  unsigned short length;        // changed bytes following
+};
+#pragma pack(pop)
+
+static void PutRun(std::vector<char> &out, size_t skip, size_t length, const char *data) {
+	archiveRun run = { (unsigned short)skip, (unsigned short)length };
+	out.insert(out.end(), (const char*)&run, (const char*)&run + sizeof(run));
+	out.insert(out.end(), data, data + length);
+}
+
+// runs of changed bytes in data against base, both size bytes long
+// changed bytes closer together than a run header are merged into one run
+static void Encode(std::vector<char> &out, const char *base, const char *data, size_t size) {
+	out.clear();
+	size_t pos = 0;
+	for (;;) {
+		size_t start = pos;
+		while (start < size && data[start] == base[start]) {
+			start++;
+		}
+		if (start == size) {
+			break;
+		}
+		size_t end = start + 1;
+		for (size_t i = end; i < size && i - end < sizeof(archiveRun); i++) {
+			if (data[i] != base[i]) {
+				end = i + 1;
+			}
+		}
+		size_t skip = start - pos;
+		while (skip > RUN_MAX) {
+			PutRun(out, RUN_MAX, 0, NULL);
+			skip -= RUN_MAX;
+		}
+		for (size_t at = start; at < end; ) {
+			size_t length = std::min(end - at, (size_t)RUN_MAX);
+			PutRun(out, skip, length, data + at);
+			skip = 0;
+			at += length;
+		}
+		pos = end;
+	}
+}
+
+// apply runs to base in place, false if they don't fit
+static bool Decode(std::vector<char> &base, const char *runs, size_t size) {
+	size_t pos = 0;
+	const char *end = runs + size;
+	while (runs < end) {
+		archiveRun run;
+		if ((size_t)(end - runs) < sizeof(run)) {
+			return false;
+		}
+		memcpy(&run, runs, sizeof(run));
+		runs += sizeof(run);
+		pos += run.skip;
+		if ((size_t)(end - runs) < run.length || pos + run.length > base.size()) {
+			return false;
+		}
+		memcpy(base.data() + pos, runs, run.length);
+		runs += run.length;
+		pos += run.length;
+	}
+	return true;
+}
+
+// follow a record through the state, its payload (if any) already in the base
+static void Track(rfArchiveState &state, unsigned int type, double time) {
+	state.time = time;
+	switch (type) {
+		case captureStartSession:
+			state.flags |= archiveInSession;
+			state.sessions++;
+			// nothing from the last session carries over
+			state.lap = 0;
+			state.sector = 0;
+			state.scoringTime = 0.0;
+			state.currentET = 0.0;
+			state.telemetry.clear();
+			state.scoring.clear();
+			break;
+		case captureEndSession: state.flags &= ~archiveInSession; break;
+		case captureEnterRealtime: state.flags |= archiveInRealtime; break;
+		case captureExitRealtime: state.flags &= ~archiveInRealtime; break;
+		case captureScoring:
+			if (state.scoring.size() >= sizeof(rfCaptureScoring)) {
+				const rfCaptureScoring *info = (const rfCaptureScoring*)state.scoring.data();
+				const rfCaptureVehicle *veh = (const rfCaptureVehicle*)(state.scoring.data() + sizeof(rfCaptureScoring));
+				size_t n = (state.scoring.size() - sizeof(rfCaptureScoring)) / sizeof(rfCaptureVehicle);
+				state.scoringTime = time;
+				state.currentET = info->mCurrentET;
+				for (size_t i = 0; i < n && i < (size_t)info->mNumVehicles; i++) {
+					if (veh[i].mIsPlayer) {
+						// lap and sector from the same record, so they never disagree at the line
+						// (telemetry's mLapNumber turns over before scoring's sector does)
+						// mSector counts 0 for sector 3
+						state.lap = veh[i].mTotalLaps + 1;
+						state.sector = veh[i].mSector ? veh[i].mSector : 3;
+						break;
+					}
+				}
+			}
+			break;
+	}
+}
+
+// session time at the last record, extrapolated from the last scoring update like the plugin's currentET
+static double CurrentET(const rfArchiveState &state) {
+	return state.scoringTime > 0.0 ? state.currentET + (state.time - state.scoringTime) : state.currentET;
+}
+
+static void ResetState(rfArchiveState &state) {
+	state.time = 0.0;
+	state.flags = 0;
+	state.sessions = 0;
+	state.lap = 0;
+	state.sector = 0;
+	state.scoringTime = 0.0;
+	state.currentET = 0.0;
+	state.telemetry.clear();
+	state.scoring.clear();
+}
+
+bool rfArchiveDetect(const char *path) {
+	FILE *f = fopen(path, "rb");
+	if (f == NULL) {
+		return false;
+	}
+	unsigned int magic = 0;
+	bool archive = fread(&magic, sizeof(magic), 1, f) == 1 && magic == RF_ARCHIVE_MAGIC;
+	fclose(f);
+	return archive;
+}
+
+rfArchiveWriter::rfArchiveWriter() : f(NULL), failed(false), position(0), interval(RF_ARCHIVE_KEYFRAME_INTERVAL), lastKeyframe(0.0) {
+	ResetState(state);
+}
+
+rfArchiveWriter::~rfArchiveWriter() {
+	Close();
+}
+
+bool rfArchiveWriter::Open(const char *path, const rfCaptureHeader &capture, double keyframeInterval) {
+	Close();
+	f = fopen(path, "wb");
+	if (f == NULL) {
+		return false;
+	}
+	failed = false;
+	position = 0;
+	interval = keyframeInterval;
+	lastKeyframe = 0.0;
+	ResetState(state);
+	index.clear();
+	rfArchiveHeader header = { RF_ARCHIVE_MAGIC, RF_ARCHIVE_VERSION, capture };
+	if (fwrite(&header, sizeof(header), 1, f) != 1) {
+		failed = true;
+	}
+	position = sizeof(header);
+	return !failed;
+}
+
+bool rfArchiveWriter::WriteFrame(const rfArchiveFrame &frame, const void *data) {
+	if (fwrite(&frame, sizeof(frame), 1, f) != 1 || (frame.size > 0 && fwrite(data, frame.size, 1, f) != 1)) {
+		failed = true;
+	}
+	position += sizeof(frame) + frame.size;
+	return !failed;
+}
+
+bool rfArchiveWriter::WritePayload(const rfCaptureRecord &record, const void *payload, std::vector<char> &base) {
+	rfArchiveFrame frame = { record.type, archiveRaw, record.size, record.size, record.time };
+	const void *data = payload;
+	if (base.size() == record.size) {
+		Encode(encoded, base.data(), (const char*)payload, record.size);
+		if (encoded.size() < record.size) {
+			frame.encoding = archiveDelta;
+			frame.size = (unsigned int)encoded.size();
+			data = encoded.data();
+		}
+	}
+	base.assign((const char*)payload, (const char*)payload + record.size);
+	return WriteFrame(frame, data);
+}
+
+bool rfArchiveWriter::WriteKeyframe(double time) {
+	rfArchiveKeyframe key = { state.flags, state.sessions, state.lap, state.sector, state.scoringTime, state.currentET,
+		(unsigned int)state.telemetry.size(), (unsigned int)state.scoring.size() };
+	rfArchiveIndexEntry entry = { time, CurrentET(state), state.sessions ? state.sessions - 1 : 0, state.lap, state.sector, 0, position };
+	encoded.assign((const char*)&key, (const char*)&key + sizeof(key));
+	encoded.insert(encoded.end(), state.telemetry.begin(), state.telemetry.end());
+	encoded.insert(encoded.end(), state.scoring.begin(), state.scoring.end());
+	rfArchiveFrame frame = { RF_ARCHIVE_KEYFRAME, archiveRaw, (unsigned int)encoded.size(), (unsigned int)encoded.size(), time };
+	index.push_back(entry);
+	lastKeyframe = entry.currentET;
+	return WriteFrame(frame, encoded.data());
+}
+
+bool rfArchiveWriter::Write(const rfCaptureRecord &record, const void *payload) {
+	if (f == NULL) {
+		return false;
+	}
+	int lap = state.lap, sector = state.sector;
+	if (record.type == captureTelemetry) {
+		WritePayload(record, payload, state.telemetry);
+	} else if (record.type == captureScoring) {
+		WritePayload(record, payload, state.scoring);
+	} else {
+		rfArchiveFrame frame = { record.type, archiveRaw, 0, 0, record.time };
+		WriteFrame(frame, NULL);
+	}
+	Track(state, record.type, record.time);
+	// keyframe each session start and every lap and sector, so seeks land on them exactly
+	if (index.empty() || record.type == captureStartSession || state.lap != lap || state.sector != sector ||
+		CurrentET(state) - lastKeyframe >= interval) {
+		WriteKeyframe(record.time);
+	}
+	return !failed;
+}
+
+bool rfArchiveWriter::Close() {
+	if (f == NULL) {
+		return false;
+	}
+	rfArchiveFooter footer = { position, (unsigned int)index.size(), RF_ARCHIVE_MAGIC };
+	if ((!index.empty() && fwrite(index.data(), sizeof(rfArchiveIndexEntry), index.size(), f) != index.size()) ||
+		fwrite(&footer, sizeof(footer), 1, f) != 1) {
+		failed = true;
+	}
+	if (fclose(f) != 0) {
+		failed = true;
+	}
+	f = NULL;
+	return !failed;
+}
+
+rfArchiveReader::rfArchiveReader() : f(NULL), position(0), dataEnd(0) {
+	memset(&header, 0, sizeof(header));
+	ResetState(state);
+}
+
+rfArchiveReader::~rfArchiveReader() {
+	Close();
+}
+
+bool rfArchiveReader::Open(const char *path) {
+	Close();
+	f = fopen(path, "rb");
+	if (f == NULL) {
+		return false;
+	}
+	rfArchiveFooter footer;
+	if (fread(&header, sizeof(header), 1, f) != 1 || header.magic != RF_ARCHIVE_MAGIC ||
+		header.version != RF_ARCHIVE_VERSION || !rfCaptureCompatible(header.capture) ||
+		fseek(f, -(long)sizeof(footer), SEEK_END) != 0 || fread(&footer, sizeof(footer), 1, f) != 1 ||
+		footer.magic != RF_ARCHIVE_MAGIC || !rfSeek(f, footer.indexOffset)) {
+		Close();
+		return false;
+	}
+	index.resize(footer.indexCount);
+	if (!index.empty() && fread(index.data(), sizeof(rfArchiveIndexEntry), index.size(), f) != index.size()) {
+		Close();
+		return false;
+	}
+	dataEnd = footer.indexOffset;
+	position = sizeof(header);
+	ResetState(state);
+	return rfSeek(f, position);
+}
+
+void rfArchiveReader::Close() {
+	if (f != NULL) {
+		fclose(f);
+		f = NULL;
+	}
+	index.clear();
+}
+
+bool rfArchiveReader::ReadKeyframe(const rfArchiveFrame &frame) {
+	rfArchiveKeyframe key;
+	if (frame.size < sizeof(key) || fread(&key, sizeof(key), 1, f) != 1 ||
+		frame.size != sizeof(key) + key.telemSize + key.scoringSize) {
+		return false;
+	}
+	state.time = frame.time;
+	state.flags = key.flags;
+	state.sessions = key.sessions;
+	state.lap = key.lap;
+	state.sector = key.sector;
+	state.scoringTime = key.scoringTime;
+	state.currentET = key.currentET;
+	state.telemetry.resize(key.telemSize);
+	state.scoring.resize(key.scoringSize);
+	return (key.telemSize == 0 || fread(state.telemetry.data(), key.telemSize, 1, f) == 1) &&
+		(key.scoringSize == 0 || fread(state.scoring.data(), key.scoringSize, 1, f) == 1);
+}
+
+bool rfArchiveReader::Seek(size_t entry) {
+	if (f == NULL || entry >= index.size() || !rfSeek(f, index[entry].offset)) {
+		return false;
+	}
+	rfArchiveFrame frame;
+	position = index[entry].offset;
+	if (fread(&frame, sizeof(frame), 1, f) != 1 || frame.type != RF_ARCHIVE_KEYFRAME || !ReadKeyframe(frame)) {
+		return false;
+	}
+	position += sizeof(frame) + frame.size;
+	return true;
+}
+
+bool rfArchiveReader::SeekBefore(size_t end) {
+	return Seek(end > 0 ? end - 1 : 0);
+}
+
+bool rfArchiveReader::SeekTime(double time) {
+	std::vector<rfArchiveIndexEntry>::const_iterator it = std::upper_bound(index.begin(), index.end(), time,
+		[](double t, const rfArchiveIndexEntry &e) { return t < e.time; });
+	return SeekBefore(it - index.begin());
+}
+
+bool rfArchiveReader::SeekET(unsigned int session, double currentET) {
+	std::vector<rfArchiveIndexEntry>::const_iterator it = std::upper_bound(index.begin(), index.end(), currentET,
+		[session](double et, const rfArchiveIndexEntry &e) {
+			return session < e.session || (session == e.session && et < e.currentET);
+		});
+	return SeekBefore(it - index.begin());
+}
+
+bool rfArchiveReader::SeekLap(unsigned int session, int lap, int sector) {
+	// the writer keeps the index in (session, lap, sector) order
+	std::vector<rfArchiveIndexEntry>::const_iterator it = std::lower_bound(index.begin(), index.end(), lap,
+		[session, sector](const rfArchiveIndexEntry &e, int l) {
+			if (e.session != session) {
+				return e.session < session;
+			}
+			return e.lap < l || (e.lap == l && e.sector < sector);
+		});
+	if (it != index.end() && it->session == session && it->lap == lap && it->sector == sector) {
+		return Seek(it - index.begin());
+	}
+	return SeekBefore(it - index.begin());
+}
+
+bool rfArchiveReader::Next(rfCaptureRecord &record, const void *&payload) {
+	while (f != NULL && position < dataEnd) {
+		rfArchiveFrame frame;
+		if (fread(&frame, sizeof(frame), 1, f) != 1) {
+			return false;
+		}
+		position += sizeof(frame) + frame.size;
+		if (frame.type == RF_ARCHIVE_KEYFRAME) {
+			// holds the state we already have when reading straight through
+			if (!rfSeek(f, position)) {
+				return false;
+			}
+			continue;
+		}
+		std::vector<char> *base = frame.type == captureTelemetry ? &state.telemetry :
+			frame.type == captureScoring ? &state.scoring : NULL;
+		if (base == NULL) {
+			if (frame.size > 0 && !rfSeek(f, position)) {
+				return false;
+			}
+		} else if (frame.encoding == archiveDelta) {
+			encoded.resize(frame.size);
+			if (base->size() != frame.rawSize || (frame.size > 0 && fread(encoded.data(), frame.size, 1, f) != 1) ||
+				!Decode(*base, encoded.data(), frame.size)) {
+				return false;
+			}
+		} else {
+			base->resize(frame.size);
+			if (frame.size > 0 && fread(base->data(), frame.size, 1, f) != 1) {
+				return false;
+			}
+		}
+		Track(state, frame.type, frame.time);
+		record.type = frame.type;
+		record.size = frame.rawSize;
+		record.time = frame.time;
+		payload = base != NULL ? base->data() : NULL;
+		return true;
+	}
+	return false;
+}
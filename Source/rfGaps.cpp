@@ -0,0 +1,162 @@
+/*
+ rfGaps.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Relative gaps between vehicles on track, see rfGaps.hpp.
+*/
+
+#include "rfGaps.hpp"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+rfGapEngine::rfGapEngine() : count(0), length(0.0f), spacing(0.0f), perMark(0.0f), lastET(0.0f), validFrom(0.0f) {
+	memset(distanceAhead, 0, sizeof(distanceAhead));
+	memset(timeAhead, 0, sizeof(timeAhead));
+	memset(distanceBehind, 0, sizeof(distanceBehind));
+	memset(timeBehind, 0, sizeof(timeBehind));
+	memset(ahead, -1, sizeof(ahead));
+	memset(behind, -1, sizeof(behind));
+	memset(dist, 0, sizeof(dist));
+	memset(order, 0, sizeof(order));
+	Reset();
+}
+
+void rfGapEngine::Reset() {
+	validFrom = 0.0f;
+	std::fill(&passed[0][0], &passed[0][0] + sizeof(passed) / sizeof(passed[0][0]), -1.0f);
+}
+
+// stamp the marks vehicle v passed going from lapDist from to lapDist to
+// between session times t0 and t1, assuming constant speed in between
+void rfGapEngine::Stamp(int v, float from, float to, float t0, float t1) {
+	float moved = to - from;
+	if (moved < 0.0f) {
+		moved += length;
+	}
+	for (int k = (int)(from * perMark) + 1; ; k++) {
+		float offset = k * spacing - from;
+		if (offset > moved) {
+			break;
+		}
+		passed[v][k % RF_GAPS_MARKS] = t0 + (t1 - t0) * (offset / moved);
+	}
+}
+
+// session time vehicle v was last at lapDist d, -1 if it hasn't been seen there since validFrom
+float rfGapEngine::PassTime(int v, float d, float et) const {
+	int k = (int)(d * perMark);
+	if (k >= RF_GAPS_MARKS) {
+		k = RF_GAPS_MARKS - 1;
+	}
+	float t0 = passed[v][k];
+	if (t0 < validFrom) {
+		return -1.0f;
+	}
+	float d0 = k * spacing;
+	float t1 = passed[v][k + 1 < RF_GAPS_MARKS ? k + 1 : 0];
+	if (t1 >= t0) {
+		return t0 + (t1 - t0) * ((d - d0) * perMark);
+	}
+	// v hasn't reached the next mark on this lap yet, so it's somewhere between the two right now
+	float reached = dist[v] - d0;
+	if (reached < 0.0f) {
+		reached += length;
+	}
+	if (reached <= 0.0f) {
+		return t0;
+	}
+	return t0 + (et - t0) * ((d - d0) / reached);
+}
+
+void rfGapEngine::Update(const float *lapDist, const float *speed, int n, float lapLength, float et) {
+	if (n > RF_SHARED_MEMORY_MAX_VEHICLES) {
+		n = RF_SHARED_MEMORY_MAX_VEHICLES;
+	}
+	if (n < 0 || lapLength <= 0.0f) {
+		n = 0;
+	}
+	// vehicles are renumbered when one joins or leaves, and on another track or
+	// after a restart the passing times mean nothing
+	bool same = n == count && lapLength == length;
+	bool restarted = et < lastET - RF_GAPS_MAX_STEP;
+	if (same && !restarted && et < lastET) {
+		// the caller's et is extrapolated from the last scoring update, so it can
+		// step back a little when the next one arrives; hold it rather than reset
+		et = lastET;
+	}
+	if ((!same || restarted) && (n > 0 || count > 0)) {
+		Reset();
+	} else if (et - lastET > RF_GAPS_MAX_STEP) {
+		// nothing to stamp the marks passed during a gap in the updates with
+		validFrom = et;
+	}
+	bool stamp = same && et >= lastET && et - lastET <= RF_GAPS_MAX_STEP;
+	if (n != count) {
+		for (int i = 0; i < n; i++) {
+			order[i] = (unsigned char)i;
+		}
+		count = n;
+	}
+	if (count == 0) {
+		return;
+	}
+	length = lapLength;
+	spacing = length / RF_GAPS_MARKS;
+	perMark = RF_GAPS_MARKS / length;
+
+	for (int v = 0; v < count; v++) {
+		// lapDist only runs past either end of the lap by what it was extrapolated
+		float d = lapDist[v];
+		if (d < 0.0f || d >= length) {
+			d -= floorf(d / length) * length;
+			d = d >= 0.0f && d < length ? d : 0.0f;
+		}
+		// anything that looks like more than half a lap in one tick is a car going backwards
+		float moved = d - dist[v];
+		if (moved < 0.0f) {
+			moved += length;
+		}
+		if (stamp && moved > 0.0f && moved < 0.5f * length) {
+			Stamp(v, dist[v], d, lastET, et);
+		}
+		dist[v] = d;
+	}
+	lastET = et;
+
+	// insertion sort, the order from the last update is almost always still right
+	for (int i = 1; i < count; i++) {
+		unsigned char v = order[i];
+		int j = i - 1;
+		while (j >= 0 && dist[order[j]] > dist[v]) {
+			order[j + 1] = order[j];
+			j--;
+		}
+		order[j + 1] = v;
+	}
+
+	if (count < 2) {
+		for (int v = 0; v < count; v++) {
+			distanceAhead[v] = timeAhead[v] = distanceBehind[v] = timeBehind[v] = 0.0f;
+			ahead[v] = behind[v] = -1;
+		}
+		return;
+	}
+	for (int r = 0; r < count; r++) {
+		int v = order[r];
+		int a = order[r + 1 < count ? r + 1 : 0];
+		ahead[v] = (signed char)a;
+		behind[a] = (signed char)v;
+		float gap = dist[a] - dist[v];
+		if (gap < 0.0f) {
+			gap += length;
+		}
+		distanceAhead[v] = gap;
+		float t = PassTime(a, dist[v], et);
+		timeAhead[v] = t >= 0.0f ? et - t : gap / (speed[v] > 1.0f ? speed[v] : 1.0f);
+	}
+	for (int v = 0; v < count; v++) {
+		distanceBehind[v] = distanceAhead[behind[v]];
+		timeBehind[v] = timeAhead[behind[v]];
+	}
+}
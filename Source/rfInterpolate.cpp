@@ -0,0 +1,34 @@
+/*
+ rfInterpolate.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Scalar and SSE instantiations of the interpolation kernel plus the runtime
+ selection between them and the AVX one (rfInterpolateAVX.cpp).
+*/
+
+#include "rfInterpolateKernel.hpp"
+#include "rfPlatform.hpp"
+
+static_assert(RF_SHARED_MEMORY_MAX_VEHICLES % RF_INTERPOLATE_MAX_LANES == 0,
+	"vehicle arrays must hold whole lanes");
+
+void rfInterpolateScalar(const rfVehicleStateSoA &in, int count, float dt, rfVehicleInterpSoA &out) {
+	rfInterpolateKernel<rfFloat1>(in, count, dt, out);
+}
+
+#ifdef RF_INTERPOLATE_X86
+void rfInterpolateSSE(const rfVehicleStateSoA &in, int count, float dt, rfVehicleInterpSoA &out) {
+	rfInterpolateKernel<rfFloat4>(in, count, dt, out);
+}
+#endif
+
+rfInterpolateFunc rfSelectInterpolate() {
+#ifdef RF_INTERPOLATE_X86
+	if (rfCpuHasAVX()) {
+		return rfInterpolateAVX;
+	}
+	return rfInterpolateSSE;
+#else
+	return rfInterpolateScalar;
+#endif
+}
@@ -0,0 +1,21 @@
+/*
+ rfInterpolateAVX.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ AVX instantiation of the interpolation kernel. This file alone is built with
+ AVX code generation (/arch:AVX, -mavx) and is only called after
+ rfSelectInterpolate has checked the CPU supports it.
+*/
+
+#include "rfInterpolateKernel.hpp"
+
+#ifdef RF_INTERPOLATE_X86
+void rfInterpolateAVX(const rfVehicleStateSoA &in, int count, float dt, rfVehicleInterpSoA &out) {
+#ifdef RF_LANE_AVX
+	rfInterpolateKernel<rfFloat8>(in, count, dt, out);
+#else
+	// built without AVX code generation
+	rfInterpolateSSE(in, count, dt, out);
+#endif
+}
+#endif
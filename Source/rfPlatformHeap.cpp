@@ -0,0 +1,152 @@
+/*
+ rfPlatformHeap.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Heap implementation of rfPlatform.hpp used by rfBench, see rfPlatformHeap.hpp.
+ Not thread-safe, the benchmark drives the plugin from a single thread.
+*/
+
+#include "rfPlatform.hpp"
+#include "rfPlatformHeap.hpp"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+struct heapBlock {
+	char name[256];
+	void *view;
+	size_t size;
+	int refs;
+};
+
+#define HEAP_MAX_BLOCKS 16
+
+static heapBlock blocks[HEAP_MAX_BLOCKS];
+static int numBlocks = 0;
+
+void* rfMapCreate(rfMapping &map, const char *name, size_t size) {
+	memset(&map, 0, sizeof(map));
+	snprintf(map.name, sizeof(map.name), "%s", name);
+	for (int i = 0; i < numBlocks; i++) {
+		if (strcmp(blocks[i].name, map.name) == 0 && blocks[i].size >= size) {
+			blocks[i].refs++;
+			map.view = blocks[i].view;
+			map.size = size;
+			return map.view;
+		}
+	}
+	if (numBlocks == HEAP_MAX_BLOCKS) {
+		return NULL;
+	}
+	// zeroed like a freshly created mapping
+	void *view = calloc(1, size);
+	if (view == NULL) {
+		return NULL;
+	}
+	heapBlock &b = blocks[numBlocks++];
+	strcpy(b.name, map.name);
+	b.view = view;
+	b.size = size;
+	b.refs = 1;
+	map.view = view;
+	map.size = size;
+	map.owner = true;
+	return view;
+}
+
+void rfMapClose(rfMapping &map) {
+	for (int i = 0; map.view && i < numBlocks; i++) {
+		if (blocks[i].view == map.view && --blocks[i].refs == 0) {
+			free(blocks[i].view);
+			blocks[i] = blocks[--numBlocks];
+			break;
+		}
+	}
+	map.view = NULL;
+	map.size = 0;
+	map.owner = false;
+}
+
+void rfMapName(char *tag, size_t len, const char *name) {
+	snprintf(tag, len, "%s", name);
+}
+
+// everything runs on one thread here, so there is never anybody to wake
+bool rfSignalOpen(rfSignal &signal, const char *name, volatile uint32_t *counter, volatile uint32_t *waiters) {
+	signal.counter = counter;
+	signal.waiters = waiters;
+	signal.handle = 0;
+	return true;
+}
+
+void rfSignalClose(rfSignal &signal) {
+	signal.counter = NULL;
+	signal.waiters = NULL;
+}
+
+void rfSignalNotify(rfSignal &signal) {
+	rfAtomicAdd(signal.counter, 1);
+}
+
+bool rfSignalWait(rfSignal &signal, uint32_t last, double timeout) {
+	return *signal.counter != last;
+}
+
+// no files behind the heap backend, so nothing can be recorded
+bool rfFileCreate(rfFile &file, const char *path) {
+	memset(&file, 0, sizeof(file));
+	return false;
+}
+
+void* rfFileMapWindow(rfFile &file, unsigned long long offset, size_t size) {
+	return NULL;
+}
+
+void rfFileClose(rfFile &file, unsigned long long length) {
+	memset(&file, 0, sizeof(file));
+}
+
+double rfClockSeconds() {
+	// steady_clock is CLOCK_MONOTONIC / QueryPerformanceCounter underneath
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool rfCpuHasAVX() {
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	int info[4];
+	__cpuid(info, 1);
+	if ((info[2] & (1 << 28)) == 0 || (info[2] & (1 << 27)) == 0) {
+		return false;
+	}
+	return (_xgetbv(0) & 6) == 6;
+#elif defined(__i386__) || defined(__x86_64__)
+	return __builtin_cpu_supports("avx");
+#else
+	return false;
+#endif
+}
+
+// nothing is shared outside the process, any id will do
+uint32_t rfProcessId() {
+	return 1;
+}
+
+int rfHeapMapCount() {
+	return numBlocks;
+}
+
+void* rfHeapMapView(int i, size_t &size) {
+	size = blocks[i].size;
+	return blocks[i].view;
+}
+
+void rfLog(const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	fprintf(stderr, "rFactorSharedMemoryMap: ");
+	vfprintf(stderr, format, args);
+	fprintf(stderr, "\n");
+	va_end(args);
+}
@@ -0,0 +1,190 @@
+/*
+ rfPlatformPosix.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ POSIX implementation of rfPlatform.hpp using shm_open/mmap, used by the
+ Linux build. Segments show up as /dev/shm/<name>. Signals are Linux futexes.
+*/
+
+#include "rfPlatform.hpp"
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+void* rfMapCreate(rfMapping &map, const char *name, size_t size) {
+	memset(&map, 0, sizeof(map));
+	// POSIX shared memory names need a leading slash
+	snprintf(map.name, sizeof(map.name), "/%s", name);
+	int fd = shm_open(map.name, O_RDWR | O_CREAT | O_EXCL, 0666);
+	if (fd >= 0) {
+		map.owner = true;
+	} else {
+		fd = shm_open(map.name, O_RDWR, 0666);
+	}
+	if (fd < 0) {
+		// unable to create or read existing
+		return NULL;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || ((size_t)st.st_size < size && ftruncate(fd, (off_t)size) != 0)) {
+		close(fd);
+		return NULL;
+	}
+	void *view = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (view == MAP_FAILED) {
+		// failed to map memory buffer
+		close(fd);
+		return NULL;
+	}
+	map.handle = fd;
+	map.view = view;
+	map.size = size;
+	return view;
+}
+
+void rfMapClose(rfMapping &map) {
+	if (map.view) {
+		munmap(map.view, map.size);
+	}
+	if (map.owner) {
+		// unlike Win32 mappings, POSIX segments outlive their last handle
+		shm_unlink(map.name);
+	}
+	if (map.handle > 0) {
+		close((int)map.handle);
+	}
+	map.view = NULL;
+	map.handle = 0;
+	map.size = 0;
+	map.owner = false;
+}
+
+void rfMapName(char *tag, size_t len, const char *name) {
+	char exe[1024] = {};
+	ssize_t n = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+	if (n > 0) {
+		exe[n] = 0;
+	}
+	// append processId for dedicated server to allow multiple instances
+	if (strstr(exe, "Dedicated") != NULL) {
+		snprintf(tag, len, "%s%lu", name, (unsigned long)getpid());
+	} else {
+		snprintf(tag, len, "%s", name);
+	}
+}
+
+// the futex is the counter word itself, so name is only needed on Windows
+bool rfSignalOpen(rfSignal &signal, const char *name, volatile uint32_t *counter, volatile uint32_t *waiters) {
+	signal.counter = counter;
+	signal.waiters = waiters;
+	signal.handle = 0;
+	return true;
+}
+
+void rfSignalClose(rfSignal &signal) {
+	signal.counter = NULL;
+	signal.waiters = NULL;
+}
+
+void rfSignalNotify(rfSignal &signal) {
+	rfAtomicAdd(signal.counter, 1);
+	// waiters only counts readers inside rfSignalWait, so it is left alone here
+	if (*signal.waiters != 0) {
+		// the segment is shared between processes, so no FUTEX_PRIVATE_FLAG
+		syscall(SYS_futex, signal.counter, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+	}
+}
+
+bool rfSignalWait(rfSignal &signal, uint32_t last, double timeout) {
+	rfAtomicAdd(signal.waiters, 1);
+	struct timespec ts;
+	ts.tv_sec = (time_t)timeout;
+	ts.tv_nsec = (long)((timeout - (double)ts.tv_sec) * 1e9);
+	// returns at once if the counter already moved past last
+	syscall(SYS_futex, signal.counter, FUTEX_WAIT, last, timeout < 0.0 ? NULL : &ts, NULL, 0);
+	// woken, timed out or never slept, we're no longer waiting
+	rfAtomicAdd(signal.waiters, (uint32_t)-1);
+	return *signal.counter != last;
+}
+
+bool rfFileCreate(rfFile &file, const char *path) {
+	memset(&file, 0, sizeof(file));
+	int fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (fd < 0) {
+		return false;
+	}
+	file.handle = fd;
+	return true;
+}
+
+void* rfFileMapWindow(rfFile &file, unsigned long long offset, size_t size) {
+	if (file.view) {
+		munmap(file.view, file.size);
+		file.view = NULL;
+	}
+	struct stat st;
+	if (fstat((int)file.handle, &st) != 0) {
+		return NULL;
+	}
+	// posix_fallocate rather than ftruncate so a full disk fails here, not with SIGBUS on a store
+	if ((unsigned long long)st.st_size < offset + size && posix_fallocate((int)file.handle, (off_t)offset, (off_t)size) != 0) {
+		return NULL;
+	}
+	void *view = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, (int)file.handle, (off_t)offset);
+	if (view == MAP_FAILED) {
+		return NULL;
+	}
+	file.view = view;
+	file.offset = offset;
+	file.size = size;
+	return view;
+}
+
+void rfFileClose(rfFile &file, unsigned long long length) {
+	if (file.view) {
+		munmap(file.view, file.size);
+	}
+	if (file.handle > 0) {
+		if (ftruncate((int)file.handle, (off_t)length) != 0) {
+			// keep the padded file rather than lose it
+		}
+		close((int)file.handle);
+	}
+	memset(&file, 0, sizeof(file));
+}
+
+double rfClockSeconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+bool rfCpuHasAVX() {
+#if defined(__i386__) || defined(__x86_64__)
+	// also checks the OS saves the YMM state
+	return __builtin_cpu_supports("avx");
+#else
+	return false;
+#endif
+}
+
+uint32_t rfProcessId() {
+	return (uint32_t)getpid();
+}
+
+void rfLog(const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	fprintf(stderr, "rFactorSharedMemoryMap: ");
+	vfprintf(stderr, format, args);
+	fprintf(stderr, "\n");
+	va_end(args);
+}
@@ -0,0 +1,225 @@
+/*
+ rfPlatformWin32.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Win32 implementation of rfPlatform.hpp using pagefile-backed file mappings.
+*/
+
+#include "rfPlatform.hpp"
+#include <Windows.h>
+#include <intrin.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+void* rfMapCreate(rfMapping &map, const char *name, size_t size) {
+	memset(&map, 0, sizeof(map));
+	strncpy(map.name, name, sizeof(map.name) - 1);
+	HANDLE hMap = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD)size, TEXT(name));
+	map.owner = (hMap != NULL && GetLastError() != ERROR_ALREADY_EXISTS);
+	if (hMap == NULL) {
+		if (GetLastError() == ERROR_ALREADY_EXISTS) {
+			hMap = OpenFileMapping(FILE_MAP_ALL_ACCESS, FALSE, TEXT(name));
+		}
+		if (hMap == NULL) {
+			// unable to create or read existing
+			return NULL;
+		}
+	}
+	// a section keeps the size it was created with, so one a reader created
+	// first may be too small for us; map all of it and check
+	void *view = MapViewOfFile(hMap, FILE_MAP_ALL_ACCESS, 0, 0, map.owner ? size : 0);
+	if (view == NULL) {
+		// failed to map memory buffer
+		rfLog("unable to map %s (error %lu)", name, (unsigned long)GetLastError());
+		CloseHandle(hMap);
+		return NULL;
+	}
+	MEMORY_BASIC_INFORMATION info = {};
+	if (!map.owner && (VirtualQuery(view, &info, sizeof(info)) != sizeof(info) || info.RegionSize < size)) {
+		rfLog("%s already exists with %lu bytes, %lu needed (was it created by a reader?)", name,
+			(unsigned long)info.RegionSize, (unsigned long)size);
+		UnmapViewOfFile(view);
+		CloseHandle(hMap);
+		return NULL;
+	}
+	map.handle = (intptr_t)hMap;
+	map.view = view;
+	map.size = size;
+	return view;
+}
+
+void rfMapClose(rfMapping &map) {
+	if (map.view) {
+		UnmapViewOfFile(map.view);
+	}
+	if (map.handle) {
+		CloseHandle((HANDLE)map.handle);
+	}
+	map.view = NULL;
+	map.handle = 0;
+	map.size = 0;
+	map.owner = false;
+}
+
+void rfMapName(char *tag, size_t len, const char *name) {
+	char exe[1024] = {};
+	GetModuleFileName(NULL, exe, sizeof(exe));
+	// append processId for dedicated server to allow multiple instances
+	if (strstr(exe, "Dedicated.exe") != NULL) {
+		_snprintf(tag, len, "%s%lu", name, (unsigned long)GetCurrentProcessId());
+	} else {
+		_snprintf(tag, len, "%s", name);
+	}
+	tag[len - 1] = 0;
+}
+
+bool rfSignalOpen(rfSignal &signal, const char *name, volatile uint32_t *counter, volatile uint32_t *waiters) {
+	signal.counter = counter;
+	signal.waiters = waiters;
+	// opens the semaphore instead if the other side created it first
+	HANDLE hSem = CreateSemaphore(NULL, 0, 0x7fffffff, TEXT(name));
+	signal.handle = (intptr_t)hSem;
+	return hSem != NULL;
+}
+
+void rfSignalClose(rfSignal &signal) {
+	if (signal.handle) {
+		CloseHandle((HANDLE)signal.handle);
+	}
+	signal.handle = 0;
+}
+
+void rfSignalNotify(rfSignal &signal) {
+	rfAtomicAdd(signal.counter, 1);
+	if (*signal.waiters != 0 && signal.handle) {
+		// one release per waiter; a waiter that leaves without its release takes it back in rfSignalWait
+		LONG n = (LONG)rfAtomicExchange(signal.waiters, 0);
+		if (n > 0) {
+			ReleaseSemaphore((HANDLE)signal.handle, n, NULL);
+		}
+	}
+}
+
+// a waiter leaving without being released: take its count back, or if the
+// writer already turned the count into a release, use that up so it can't
+// end the next wait early
+static void SignalLeave(rfSignal &signal) {
+	for (;;) {
+		uint32_t n = *signal.waiters;
+		if (n == 0) {
+			// the writer releases right after taking the counts, bounded in case it died in between
+			if (signal.handle) {
+				WaitForSingleObject((HANDLE)signal.handle, 1000);
+			}
+			return;
+		}
+		if (rfAtomicCompareExchange(signal.waiters, n, n - 1) == n) {
+			return;
+		}
+	}
+}
+
+bool rfSignalWait(rfSignal &signal, uint32_t last, double timeout) {
+	rfAtomicAdd(signal.waiters, 1);
+	// counted before checking, so a publication in between still releases us
+	if (*signal.counter == last && signal.handle &&
+		WaitForSingleObject((HANDLE)signal.handle, timeout < 0.0 ? INFINITE : (DWORD)(timeout * 1000.0)) == WAIT_OBJECT_0) {
+		// the writer took our count when it released us
+		return *signal.counter != last;
+	}
+	SignalLeave(signal);
+	return *signal.counter != last;
+}
+
+bool rfFileCreate(rfFile &file, const char *path) {
+	memset(&file, 0, sizeof(file));
+	HANDLE hFile = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	file.handle = (intptr_t)hFile;
+	return true;
+}
+
+void* rfFileMapWindow(rfFile &file, unsigned long long offset, size_t size) {
+	if (file.view) {
+		UnmapViewOfFile(file.view);
+		file.view = NULL;
+	}
+	if (file.mapHandle) {
+		CloseHandle((HANDLE)file.mapHandle);
+		file.mapHandle = 0;
+	}
+	// a mapping larger than the file extends it
+	unsigned long long end = offset + size;
+	HANDLE hMap = CreateFileMapping((HANDLE)file.handle, NULL, PAGE_READWRITE, (DWORD)(end >> 32), (DWORD)end, NULL);
+	if (hMap == NULL) {
+		return NULL;
+	}
+	void *view = MapViewOfFile(hMap, FILE_MAP_WRITE, (DWORD)(offset >> 32), (DWORD)offset, size);
+	if (view == NULL) {
+		CloseHandle(hMap);
+		return NULL;
+	}
+	file.mapHandle = (intptr_t)hMap;
+	file.view = view;
+	file.offset = offset;
+	file.size = size;
+	return view;
+}
+
+void rfFileClose(rfFile &file, unsigned long long length) {
+	if (file.view) {
+		UnmapViewOfFile(file.view);
+	}
+	if (file.mapHandle) {
+		CloseHandle((HANDLE)file.mapHandle);
+	}
+	if (file.handle) {
+		LARGE_INTEGER end;
+		end.QuadPart = (LONGLONG)length;
+		SetFilePointerEx((HANDLE)file.handle, end, NULL, FILE_BEGIN);
+		SetEndOfFile((HANDLE)file.handle);
+		CloseHandle((HANDLE)file.handle);
+	}
+	memset(&file, 0, sizeof(file));
+}
+
+double rfClockSeconds() {
+	static double period = 0.0;
+	if (period == 0.0) {
+		LARGE_INTEGER freq;
+		QueryPerformanceFrequency(&freq);
+		period = 1.0 / (double)freq.QuadPart;
+	}
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+	return (double)now.QuadPart * period;
+}
+
+bool rfCpuHasAVX() {
+	int info[4];
+	__cpuid(info, 1);
+	// AVX and OSXSAVE, then check the OS saves the YMM state
+	if ((info[2] & (1 << 28)) == 0 || (info[2] & (1 << 27)) == 0) {
+		return false;
+	}
+	return (_xgetbv(0) & 6) == 6;
+}
+
+uint32_t rfProcessId() {
+	return (uint32_t)GetCurrentProcessId();
+}
+
+void rfLog(const char *format, ...) {
+	char line[512];
+	int n = _snprintf(line, sizeof(line) - 2, "rFactorSharedMemoryMap: ");
+	va_list args;
+	va_start(args, format);
+	_vsnprintf(line + n, sizeof(line) - 2 - n, format, args);
+	va_end(args);
+	line[sizeof(line) - 2] = 0;
+	strcat(line, "\n");
+	OutputDebugStringA(line);
+}
@@ -0,0 +1,159 @@
+/*
+ rfRecorder.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Asynchronous capture writer, see rfRecorder.hpp.
+*/
+
+#include "rfRecorder.hpp"
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+rfRecorder::rfRecorder() : recording(false), queue(NULL), head(0), tail(0), stopping(false), failed(false), written(0),
+	records(0), dropped(0), startTime(0.0) {
+	memset(&file, 0, sizeof(file));
+	memset(&telem, 0, sizeof(telem));
+	memset(&scoring, 0, sizeof(scoring));
+}
+
+rfRecorder::~rfRecorder() {
+	Stop();
+}
+
+bool rfRecorder::Start(const char *path) {
+	Stop();
+	// the file first, so a name that's taken fails before allocating anything
+	if (!rfFileCreate(file, path)) {
+		return false;
+	}
+	char *window = (char*)rfFileMapWindow(file, 0, RF_RECORDER_WINDOW_SIZE);
+	queue = window ? (char*)malloc(RF_RECORDER_QUEUE_SIZE) : NULL;
+	if (queue == NULL) {
+		rfFileClose(file, 0);
+		return false;
+	}
+	// fault the queue in now rather than on the sim's first few updates
+	memset(queue, 0, RF_RECORDER_QUEUE_SIZE);
+	// and room for any field rFactor runs, so scoring updates don't allocate
+	vehicles.reserve(128);
+	rfCaptureHeader header = rfCaptureMakeHeader();
+	memcpy(window, &header, sizeof(header));
+	written = sizeof(header);
+	head = 0;
+	tail = 0;
+	stopping = false;
+	failed = false;
+	records = 0;
+	dropped = 0;
+	startTime = rfClockSeconds();
+	recording = true;
+	writer = std::thread(&rfRecorder::Run, this);
+	return true;
+}
+
+void rfRecorder::Stop() {
+	if (!recording) {
+		return;
+	}
+	recording = false;
+	stopping.store(true, std::memory_order_release);
+	writer.join();
+	rfFileClose(file, written);
+	free(queue);
+	queue = NULL;
+}
+
+void rfRecorder::Put(unsigned long long pos, const void *data, size_t size) {
+	if (size == 0) {
+		return;
+	}
+	size_t at = (size_t)(pos & (RF_RECORDER_QUEUE_SIZE - 1));
+	size_t first = RF_RECORDER_QUEUE_SIZE - at < size ? RF_RECORDER_QUEUE_SIZE - at : size;
+	memcpy(queue + at, data, first);
+	memcpy(queue, (const char*)data + first, size - first);
+}
+
+void rfRecorder::Record(rfCaptureType type, const void *payload, size_t size, const void *extra, size_t extraSize) {
+	if (!recording) {
+		return;
+	}
+	rfCaptureRecord record = { (unsigned int)type, (unsigned int)(size + extraSize), rfClockSeconds() - startTime };
+	unsigned long long total = sizeof(record) + size + extraSize;
+	unsigned long long h = head.load(std::memory_order_relaxed);
+	if (total > RF_RECORDER_QUEUE_SIZE - (h - tail.load(std::memory_order_acquire))) {
+		dropped++;
+		return;
+	}
+	Put(h, &record, sizeof(record));
+	Put(h + sizeof(record), payload, size);
+	Put(h + sizeof(record) + size, extra, extraSize);
+	head.store(h + total, std::memory_order_release);
+	records++;
+}
+
+void rfRecorder::RecordTelemetry(const TelemInfoV2 &info) {
+	if (!recording) {
+		return;
+	}
+	rfCaptureFromTelem(info, telem);
+	Record(captureTelemetry, &telem, sizeof(telem));
+}
+
+void rfRecorder::RecordScoring(const ScoringInfoV2 &info) {
+	if (!recording) {
+		return;
+	}
+	rfCaptureFromScoring(info, scoring);
+	size_t n = info.mNumVehicles > 0 && info.mVehicle != NULL ? (size_t)info.mNumVehicles : 0;
+	if (vehicles.size() < n) {
+		vehicles.resize(n);
+	}
+	for (size_t i = 0; i < n; i++) {
+		rfCaptureFromVehicle(info.mVehicle[i], vehicles[i]);
+	}
+	scoring.mNumVehicles = (int32_t)n;
+	Record(captureScoring, &scoring, sizeof(scoring), vehicles.data(), n * sizeof(rfCaptureVehicle));
+}
+
+void rfRecorder::Run() {
+	unsigned long long t = tail.load(std::memory_order_relaxed);
+	unsigned long long pos = written.load(std::memory_order_relaxed);
+	char *window = (char*)file.view;
+	for (;;) {
+		// read the flag first so nothing queued before Stop is left behind
+		bool last = stopping.load(std::memory_order_acquire);
+		unsigned long long h = head.load(std::memory_order_acquire);
+		while (t != h) {
+			size_t at = (size_t)(t & (RF_RECORDER_QUEUE_SIZE - 1));
+			size_t n = (size_t)(h - t);
+			if (n > RF_RECORDER_QUEUE_SIZE - at) {
+				n = RF_RECORDER_QUEUE_SIZE - at;
+			}
+			if (window != NULL) {
+				if (pos == file.offset + file.size) {
+					// move the window along, growing the file
+					window = (char*)rfFileMapWindow(file, pos, RF_RECORDER_WINDOW_SIZE);
+					if (window == NULL) {
+						failed.store(true, std::memory_order_relaxed);
+						continue;
+					}
+				}
+				size_t room = (size_t)(file.offset + file.size - pos);
+				if (n > room) {
+					n = room;
+				}
+				memcpy(window + (pos - file.offset), queue + at, n);
+				pos += n;
+				written.store(pos, std::memory_order_relaxed);
+			}
+			// once the file can't grow the queue is still drained so Record never blocks
+			t += n;
+			tail.store(t, std::memory_order_release);
+		}
+		if (last) {
+			break;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+}
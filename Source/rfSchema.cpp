@@ -0,0 +1,426 @@
+/*
+ rfSchema.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Compile-time field descriptors of the published structs, see rfSchema.hpp.
+ A member whose type has no rfSchemaElement below fails to compile, so new
+ members can't be published without being described.
+*/
+
+#include "rfSchema.hpp"
+#include <string.h>
+
+// every described struct, in the order of rfSchema::structs
+// top-level structs name the map they're published as
+#define RF_SCHEMA_STRUCTS(X) \
+	X(rfShared, RF_SHARED_MEMORY_NAME) \
+	X(rfWheel, "") \
+	X(rfVehicleInfo, "") \
+	X(rfStandings, "") \
+	X(rfTelemetryFrame, "") \
+	X(rfTelemetrySegment, RF_SHARED_MEMORY_TELEMETRY_NAME) \
+	X(rfScoringSegment, RF_SHARED_MEMORY_SCORING_NAME) \
+	X(rfVehicleSegment, RF_SHARED_MEMORY_VEHICLES_NAME) \
+	X(rfSessionSegment, RF_SHARED_MEMORY_SESSION_NAME) \
+	X(rfGraphicsSegment, RF_SHARED_MEMORY_GRAPHICS_NAME) \
+	X(rfTrackKnot, "") \
+	X(rfTrackSegment, RF_SHARED_MEMORY_TRACK_NAME) \
+	X(rfStringTable, RF_SHARED_MEMORY_STRINGS_NAME) \
+	X(rfVec3SoA, "") \
+	X(rfVehicleStateSoA, "") \
+	X(rfScoringState, RF_SHARED_MEMORY_SCORING_STATE_NAME) \
+	X(rfHistory, RF_SHARED_MEMORY_HISTORY_NAME) \
+	X(rfLatencyStats, "") \
+	X(rfStats, RF_SHARED_MEMORY_STATS_NAME) \
+	X(rfReaderSlot, "") \
+	X(rfReaderStatus, "") \
+	X(rfReaderTable, RF_SHARED_MEMORY_READERS_NAME)
+
+#define RF_SCHEMA_ID(S, map) schemaId_##S,
+enum {
+	RF_SCHEMA_STRUCTS(RF_SCHEMA_ID)
+	schemaIdCount
+};
+static_assert(schemaIdCount <= RF_SHARED_MEMORY_SCHEMA_STRUCTS, "raise RF_SHARED_MEMORY_SCHEMA_STRUCTS");
+
+// element type, struct reference and element count of a member type
+template <class T> struct rfSchemaElement;
+
+#define RF_SCHEMA_SCALAR(T, t) \
+	template <> struct rfSchemaElement<T> { enum { type = t, ref = 0, count = 1 }; typedef T scalar; };
+RF_SCHEMA_SCALAR(signed char, schemaInt8)
+RF_SCHEMA_SCALAR(unsigned char, schemaUInt8)
+RF_SCHEMA_SCALAR(short, schemaInt16)
+RF_SCHEMA_SCALAR(uint16_t, schemaUInt16)
+RF_SCHEMA_SCALAR(int32_t, schemaInt32)
+RF_SCHEMA_SCALAR(uint32_t, schemaUInt32)
+RF_SCHEMA_SCALAR(uint64_t, schemaUInt64)
+RF_SCHEMA_SCALAR(float, schemaFloat)
+RF_SCHEMA_SCALAR(double, schemaDouble)
+RF_SCHEMA_SCALAR(char, schemaChar)
+RF_SCHEMA_SCALAR(bool, schemaBool)
+
+// vectors are flattened to three floats
+template <> struct rfSchemaElement<rfVec3> { enum { type = schemaFloat, ref = 0, count = 3 }; typedef float scalar; };
+
+#define RF_SCHEMA_NESTED(S, map) \
+	template <> struct rfSchemaElement<S> { enum { type = schemaStruct, ref = schemaId_##S, count = 1 }; typedef S scalar; };
+RF_SCHEMA_STRUCTS(RF_SCHEMA_NESTED)
+
+template <class T, size_t N> struct rfSchemaElement<T[N]> {
+	enum { type = rfSchemaElement<T>::type, ref = rfSchemaElement<T>::ref, count = N * rfSchemaElement<T>::count };
+	typedef typename rfSchemaElement<T>::scalar scalar;
+};
+
+#define RF_SCHEMA_E(S, member) rfSchemaElement<decltype(((S*)0)->member)>
+#define RF_FIELD(S, member, unit) { #member, unit, RF_SCHEMA_E(S, member)::type, RF_SCHEMA_E(S, member)::ref, \
+	offsetof(S, member), sizeof(RF_SCHEMA_E(S, member)::scalar), RF_SCHEMA_E(S, member)::count, {} }
+
+// player telemetry, laid out the same in rfShared and rfTelemetryFrame
+#define RF_SCHEMA_TELEMETRY(S) \
+	RF_FIELD(S, telemetryTime, "s"), \
+	RF_FIELD(S, deltaTime, "s"), \
+	RF_FIELD(S, lapNumber, ""), \
+	RF_FIELD(S, lapStartET, "s"), \
+	RF_FIELD(S, trackName, ""), \
+	RF_FIELD(S, pos, "m"), \
+	RF_FIELD(S, localVel, "m/s"), \
+	RF_FIELD(S, localAccel, "m/s^2"), \
+	RF_FIELD(S, oriX, ""), \
+	RF_FIELD(S, oriY, ""), \
+	RF_FIELD(S, oriZ, ""), \
+	RF_FIELD(S, localRot, "rad/s"), \
+	RF_FIELD(S, localRotAccel, "rad/s^2"), \
+	RF_FIELD(S, speed, "m/s"), \
+	RF_FIELD(S, gear, ""), \
+	RF_FIELD(S, engineRPM, "rpm"), \
+	RF_FIELD(S, engineWaterTemp, "degC"), \
+	RF_FIELD(S, engineOilTemp, "degC"), \
+	RF_FIELD(S, clutchRPM, "rpm"), \
+	RF_FIELD(S, unfilteredThrottle, ""), \
+	RF_FIELD(S, unfilteredBrake, ""), \
+	RF_FIELD(S, unfilteredSteering, ""), \
+	RF_FIELD(S, unfilteredClutch, ""), \
+	RF_FIELD(S, steeringArmForce, "N"), \
+	RF_FIELD(S, fuel, "l"), \
+	RF_FIELD(S, engineMaxRPM, "rpm"), \
+	RF_FIELD(S, scheduledStops, ""), \
+	RF_FIELD(S, overheating, ""), \
+	RF_FIELD(S, detached, ""), \
+	RF_FIELD(S, dentSeverity, ""), \
+	RF_FIELD(S, lastImpactET, "s"), \
+	RF_FIELD(S, lastImpactMagnitude, ""), \
+	RF_FIELD(S, lastImpactPos, "m"), \
+	RF_FIELD(S, wheel, ""), \
+	RF_FIELD(S, trackNameId, "")
+
+static const rfSchemaField rfSharedFields[] = {
+	RF_FIELD(rfShared, version, ""),
+	RF_FIELD(rfShared, sequence, ""),
+	RF_FIELD(rfShared, currentET, "s"),
+	RF_FIELD(rfShared, inRealtime, ""),
+	RF_FIELD(rfShared, readerFlags, ""),
+	RF_FIELD(rfShared, telemetrySignal, ""),
+	RF_FIELD(rfShared, telemetryWaiters, ""),
+	RF_FIELD(rfShared, scoringSignal, ""),
+	RF_FIELD(rfShared, scoringWaiters, ""),
+	RF_SCHEMA_TELEMETRY(rfShared),
+	RF_FIELD(rfShared, scoringTime, "s"),
+	RF_FIELD(rfShared, scoringET, "s"),
+	RF_FIELD(rfShared, session, ""),
+	RF_FIELD(rfShared, endET, "s"),
+	RF_FIELD(rfShared, maxLaps, ""),
+	RF_FIELD(rfShared, lapDist, "m"),
+	RF_FIELD(rfShared, numVehicles, ""),
+	RF_FIELD(rfShared, gamePhase, ""),
+	RF_FIELD(rfShared, yellowFlagState, ""),
+	RF_FIELD(rfShared, sectorFlag, ""),
+	RF_FIELD(rfShared, startLight, ""),
+	RF_FIELD(rfShared, numRedLights, ""),
+	RF_FIELD(rfShared, playerName, ""),
+	RF_FIELD(rfShared, ambientTemp, "degC"),
+	RF_FIELD(rfShared, trackTemp, "degC"),
+	RF_FIELD(rfShared, wind, "m/s"),
+	RF_FIELD(rfShared, scoringGeneration, ""),
+	RF_FIELD(rfShared, changedVehicles, ""),
+	RF_FIELD(rfShared, vehicle, ""),
+	RF_FIELD(rfShared, standings, "")
+};
+
+static const rfSchemaField rfWheelFields[] = {
+	RF_FIELD(rfWheel, rotation, "rad/s"),
+	RF_FIELD(rfWheel, suspensionDeflection, "m"),
+	RF_FIELD(rfWheel, rideHeight, "m"),
+	RF_FIELD(rfWheel, tireLoad, "N"),
+	RF_FIELD(rfWheel, lateralForce, "N"),
+	RF_FIELD(rfWheel, gripFract, ""),
+	RF_FIELD(rfWheel, brakeTemp, "degC"),
+	RF_FIELD(rfWheel, pressure, "kPa"),
+	RF_FIELD(rfWheel, temperature, "degC"),
+	RF_FIELD(rfWheel, wear, ""),
+	RF_FIELD(rfWheel, terrainName, ""),
+	RF_FIELD(rfWheel, surfaceType, ""),
+	RF_FIELD(rfWheel, flat, ""),
+	RF_FIELD(rfWheel, detached, ""),
+	RF_FIELD(rfWheel, terrainNameId, "")
+};
+
+static const rfSchemaField rfVehicleInfoFields[] = {
+	RF_FIELD(rfVehicleInfo, pos, "m"),
+	RF_FIELD(rfVehicleInfo, yaw, "rad"),
+	RF_FIELD(rfVehicleInfo, pitch, "rad"),
+	RF_FIELD(rfVehicleInfo, roll, "rad"),
+	RF_FIELD(rfVehicleInfo, speed, "m/s"),
+	RF_FIELD(rfVehicleInfo, lapDist, "m"),
+	RF_FIELD(rfVehicleInfo, distanceAhead, "m"),
+	RF_FIELD(rfVehicleInfo, timeAhead, "s"),
+	RF_FIELD(rfVehicleInfo, distanceBehind, "m"),
+	RF_FIELD(rfVehicleInfo, timeBehind, "s"),
+	RF_FIELD(rfVehicleInfo, vehicleAhead, ""),
+	RF_FIELD(rfVehicleInfo, vehicleBehind, ""),
+	RF_FIELD(rfVehicleInfo, driverName, ""),
+	RF_FIELD(rfVehicleInfo, totalLaps, ""),
+	RF_FIELD(rfVehicleInfo, sector, ""),
+	RF_FIELD(rfVehicleInfo, finishStatus, ""),
+	RF_FIELD(rfVehicleInfo, pathLateral, "m"),
+	RF_FIELD(rfVehicleInfo, trackEdge, "m"),
+	RF_FIELD(rfVehicleInfo, bestSector1, "s"),
+	RF_FIELD(rfVehicleInfo, bestSector2, "s"),
+	RF_FIELD(rfVehicleInfo, bestLapTime, "s"),
+	RF_FIELD(rfVehicleInfo, lastSector1, "s"),
+	RF_FIELD(rfVehicleInfo, lastSector2, "s"),
+	RF_FIELD(rfVehicleInfo, lastLapTime, "s"),
+	RF_FIELD(rfVehicleInfo, curSector1, "s"),
+	RF_FIELD(rfVehicleInfo, curSector2, "s"),
+	RF_FIELD(rfVehicleInfo, numPitstops, ""),
+	RF_FIELD(rfVehicleInfo, numPenalties, ""),
+	RF_FIELD(rfVehicleInfo, isPlayer, ""),
+	RF_FIELD(rfVehicleInfo, control, ""),
+	RF_FIELD(rfVehicleInfo, inPits, ""),
+	RF_FIELD(rfVehicleInfo, place, ""),
+	RF_FIELD(rfVehicleInfo, vehicleClass, ""),
+	RF_FIELD(rfVehicleInfo, timeBehindNext, "s"),
+	RF_FIELD(rfVehicleInfo, lapsBehindNext, ""),
+	RF_FIELD(rfVehicleInfo, timeBehindLeader, "s"),
+	RF_FIELD(rfVehicleInfo, lapsBehindLeader, ""),
+	RF_FIELD(rfVehicleInfo, lapStartET, "s"),
+	RF_FIELD(rfVehicleInfo, driverNameId, ""),
+	RF_FIELD(rfVehicleInfo, vehicleClassNameId, ""),
+	RF_FIELD(rfVehicleInfo, generation, "")
+};
+
+static const rfSchemaField rfStandingsFields[] = {
+	RF_FIELD(rfStandings, generation, ""),
+	RF_FIELD(rfStandings, numVehicles, ""),
+	RF_FIELD(rfStandings, numClasses, ""),
+	RF_FIELD(rfStandings, overall, ""),
+	RF_FIELD(rfStandings, byClass, ""),
+	RF_FIELD(rfStandings, classStart, ""),
+	RF_FIELD(rfStandings, classCount, ""),
+	RF_FIELD(rfStandings, vehicleClassId, ""),
+	RF_FIELD(rfStandings, classPlace, "")
+};
+
+static const rfSchemaField rfTelemetryFrameFields[] = {
+	RF_FIELD(rfTelemetryFrame, sequence, ""),
+	RF_FIELD(rfTelemetryFrame, currentET, "s"),
+	RF_SCHEMA_TELEMETRY(rfTelemetryFrame)
+};
+
+static const rfSchemaField rfTelemetrySegmentFields[] = {
+	RF_FIELD(rfTelemetrySegment, version, ""),
+	RF_FIELD(rfTelemetrySegment, sequence, ""),
+	RF_FIELD(rfTelemetrySegment, telemetry, "")
+};
+
+static const rfSchemaField rfScoringSegmentFields[] = {
+	RF_FIELD(rfScoringSegment, version, ""),
+	RF_FIELD(rfScoringSegment, sequence, ""),
+	RF_FIELD(rfScoringSegment, scoringTime, "s"),
+	RF_FIELD(rfScoringSegment, currentET, "s"),
+	RF_FIELD(rfScoringSegment, session, ""),
+	RF_FIELD(rfScoringSegment, endET, "s"),
+	RF_FIELD(rfScoringSegment, maxLaps, ""),
+	RF_FIELD(rfScoringSegment, lapDist, "m"),
+	RF_FIELD(rfScoringSegment, numVehicles, ""),
+	RF_FIELD(rfScoringSegment, gamePhase, ""),
+	RF_FIELD(rfScoringSegment, yellowFlagState, ""),
+	RF_FIELD(rfScoringSegment, sectorFlag, ""),
+	RF_FIELD(rfScoringSegment, startLight, ""),
+	RF_FIELD(rfScoringSegment, numRedLights, ""),
+	RF_FIELD(rfScoringSegment, inRealtime, ""),
+	RF_FIELD(rfScoringSegment, ambientTemp, "degC"),
+	RF_FIELD(rfScoringSegment, trackTemp, "degC"),
+	RF_FIELD(rfScoringSegment, wind, "m/s")
+};
+
+static const rfSchemaField rfVehicleSegmentFields[] = {
+	RF_FIELD(rfVehicleSegment, version, ""),
+	RF_FIELD(rfVehicleSegment, sequence, ""),
+	RF_FIELD(rfVehicleSegment, numVehicles, ""),
+	RF_FIELD(rfVehicleSegment, scoringTime, "s"),
+	RF_FIELD(rfVehicleSegment, currentET, "s"),
+	RF_FIELD(rfVehicleSegment, scoringGeneration, ""),
+	RF_FIELD(rfVehicleSegment, changedVehicles, ""),
+	RF_FIELD(rfVehicleSegment, capacity, ""),
+	RF_FIELD(rfVehicleSegment, standings, ""),
+	RF_FIELD(rfVehicleSegment, vehicle, "")
+};
+
+static const rfSchemaField rfSessionSegmentFields[] = {
+	RF_FIELD(rfSessionSegment, version, ""),
+	RF_FIELD(rfSessionSegment, sequence, ""),
+	RF_FIELD(rfSessionSegment, trackName, ""),
+	RF_FIELD(rfSessionSegment, playerName, ""),
+	RF_FIELD(rfSessionSegment, plrFileName, "")
+};
+
+static const rfSchemaField rfGraphicsSegmentFields[] = {
+	RF_FIELD(rfGraphicsSegment, version, ""),
+	RF_FIELD(rfGraphicsSegment, sequence, ""),
+	RF_FIELD(rfGraphicsSegment, frames, ""),
+	RF_FIELD(rfGraphicsSegment, graphicsTime, "s"),
+	RF_FIELD(rfGraphicsSegment, camPos, "m"),
+	RF_FIELD(rfGraphicsSegment, camOri, ""),
+	RF_FIELD(rfGraphicsSegment, ambientRed, ""),
+	RF_FIELD(rfGraphicsSegment, ambientGreen, ""),
+	RF_FIELD(rfGraphicsSegment, ambientBlue, "")
+};
+
+static const rfSchemaField rfTrackKnotFields[] = {
+	RF_FIELD(rfTrackKnot, pos, "m"),
+	RF_FIELD(rfTrackKnot, heading, "rad"),
+	RF_FIELD(rfTrackKnot, weight, "")
+};
+
+static const rfSchemaField rfTrackSegmentFields[] = {
+	RF_FIELD(rfTrackSegment, version, ""),
+	RF_FIELD(rfTrackSegment, sequence, ""),
+	RF_FIELD(rfTrackSegment, numKnots, ""),
+	RF_FIELD(rfTrackSegment, length, "m"),
+	RF_FIELD(rfTrackSegment, spacing, "m"),
+	RF_FIELD(rfTrackSegment, learned, ""),
+	RF_FIELD(rfTrackSegment, trackName, ""),
+	RF_FIELD(rfTrackSegment, knot, "")
+};
+
+// the unit of an rfVec3SoA is that of the member holding it
+static const rfSchemaField rfStringTableFields[] = {
+	RF_FIELD(rfStringTable, version, ""),
+	RF_FIELD(rfStringTable, sequence, ""),
+	RF_FIELD(rfStringTable, numStrings, ""),
+	RF_FIELD(rfStringTable, text, "")
+};
+
+static const rfSchemaField rfVec3SoAFields[] = {
+	RF_FIELD(rfVec3SoA, x, ""),
+	RF_FIELD(rfVec3SoA, y, ""),
+	RF_FIELD(rfVec3SoA, z, "")
+};
+
+static const rfSchemaField rfVehicleStateSoAFields[] = {
+	RF_FIELD(rfVehicleStateSoA, lapDist, "m"),
+	RF_FIELD(rfVehicleStateSoA, pos, "m"),
+	RF_FIELD(rfVehicleStateSoA, localVel, "m/s"),
+	RF_FIELD(rfVehicleStateSoA, localAccel, "m/s^2"),
+	RF_FIELD(rfVehicleStateSoA, oriX, ""),
+	RF_FIELD(rfVehicleStateSoA, oriY, ""),
+	RF_FIELD(rfVehicleStateSoA, oriZ, ""),
+	RF_FIELD(rfVehicleStateSoA, localRot, "rad/s"),
+	RF_FIELD(rfVehicleStateSoA, localRotAccel, "rad/s^2")
+};
+
+static const rfSchemaField rfScoringStateFields[] = {
+	RF_FIELD(rfScoringState, version, ""),
+	RF_FIELD(rfScoringState, sequence, ""),
+	RF_FIELD(rfScoringState, numVehicles, ""),
+	RF_FIELD(rfScoringState, scoringTime, "s"),
+	RF_FIELD(rfScoringState, currentET, "s"),
+	RF_FIELD(rfScoringState, vehicle, "")
+};
+
+static const rfSchemaField rfHistoryFields[] = {
+	RF_FIELD(rfHistory, version, ""),
+	RF_FIELD(rfHistory, capacity, ""),
+	RF_FIELD(rfHistory, head, ""),
+	RF_FIELD(rfHistory, frame, "")
+};
+
+static const rfSchemaField rfLatencyStatsFields[] = {
+	RF_FIELD(rfLatencyStats, calls, ""),
+	RF_FIELD(rfLatencyStats, totalCycles, "cycles"),
+	RF_FIELD(rfLatencyStats, maxCycles, "cycles"),
+	RF_FIELD(rfLatencyStats, bucket, "")
+};
+
+static const rfSchemaField rfStatsFields[] = {
+	RF_FIELD(rfStats, version, ""),
+	RF_FIELD(rfStats, sequence, ""),
+	RF_FIELD(rfStats, numProbes, ""),
+	RF_FIELD(rfStats, cyclesPerSecond, "Hz"),
+	RF_FIELD(rfStats, probe, ""),
+	RF_FIELD(rfStats, recording, ""),
+	RF_FIELD(rfStats, recordFailed, ""),
+	RF_FIELD(rfStats, vehiclesUnmapped, ""),
+	RF_FIELD(rfStats, recordedRecords, ""),
+	RF_FIELD(rfStats, droppedRecords, ""),
+	RF_FIELD(rfStats, recordedBytes, "B")
+};
+
+static const rfSchemaField rfReaderSlotFields[] = {
+	RF_FIELD(rfReaderSlot, owner, ""),
+	RF_FIELD(rfReaderSlot, pid, ""),
+	RF_FIELD(rfReaderSlot, heartbeat, "s"),
+	RF_FIELD(rfReaderSlot, cursor, ""),
+	RF_FIELD(rfReaderSlot, name, "")
+};
+
+static const rfSchemaField rfReaderStatusFields[] = {
+	RF_FIELD(rfReaderStatus, owner, ""),
+	RF_FIELD(rfReaderStatus, lag, ""),
+	RF_FIELD(rfReaderStatus, maxLag, ""),
+	RF_FIELD(rfReaderStatus, overruns, "")
+};
+
+static const rfSchemaField rfReaderTableFields[] = {
+	RF_FIELD(rfReaderTable, version, ""),
+	RF_FIELD(rfReaderTable, numSlots, ""),
+	RF_FIELD(rfReaderTable, head, ""),
+	RF_FIELD(rfReaderTable, registrations, ""),
+	RF_FIELD(rfReaderTable, slot, ""),
+	RF_FIELD(rfReaderTable, status, "")
+};
+
+#define RF_SCHEMA_COUNT(S, map) + sizeof(S##Fields) / sizeof(S##Fields[0])
+static_assert(0 RF_SCHEMA_STRUCTS(RF_SCHEMA_COUNT) <= RF_SHARED_MEMORY_SCHEMA_FIELDS, "raise RF_SHARED_MEMORY_SCHEMA_FIELDS");
+
+struct rfSchemaSource {
+  const char *name;
+  const char *map;
+  uint32_t size;
+  const rfSchemaField *fields;
+  uint16_t numFields;
+};
+
+#define RF_SCHEMA_SOURCE(S, map) { #S, map, sizeof(S), S##Fields, sizeof(S##Fields) / sizeof(S##Fields[0]) },
+static const rfSchemaSource sources[] = {
+	RF_SCHEMA_STRUCTS(RF_SCHEMA_SOURCE)
+};
+
+void rfSchemaFill(rfSchema &schema) {
+	memset(schema.structs, 0, sizeof(schema.structs));
+	memset(schema.field, 0, sizeof(schema.field));
+	uint16_t next = 0;
+	for (int i = 0; i < schemaIdCount; i++) {
+		rfSchemaStruct &s = schema.structs[i];
+		strncpy(s.name, sources[i].name, sizeof(s.name) - 1);
+		strncpy(s.map, sources[i].map, sizeof(s.map) - 1);
+		s.size = sources[i].size;
+		s.firstField = next;
+		s.numFields = sources[i].numFields;
+		memcpy(&schema.field[next], sources[i].fields, sources[i].numFields * sizeof(rfSchemaField));
+		next += sources[i].numFields;
+	}
+	schema.numStructs = schemaIdCount;
+	schema.numFields = next;
+}
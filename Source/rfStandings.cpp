@@ -0,0 +1,92 @@
+/*
+ rfStandings.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Overall and per-class standings, see rfStandings.hpp.
+*/
+
+#include "rfStandings.hpp"
+#include <string.h>
+
+rfStandingsBuilder::rfStandingsBuilder() : generation(0) {
+	Reset();
+}
+
+void rfStandingsBuilder::Reset() {
+	count = -1;
+	memset(place, 0, sizeof(place));
+	memset(vehicleClass, 0, sizeof(vehicleClass));
+}
+
+bool rfStandingsBuilder::Update(const rfVehicleInfo *vehicle, int n, rfStandings &standings) {
+	if (n < 0) {
+		n = 0;
+	}
+	if (n > RF_SHARED_MEMORY_MAX_VEHICLES) {
+		n = RF_SHARED_MEMORY_MAX_VEHICLES;
+	}
+	bool changed = n != count;
+	for (int i = 0; i < n; i++) {
+		if (vehicle[i].place != place[i] || strncmp(vehicle[i].vehicleClass, vehicleClass[i], sizeof(vehicleClass[i])) != 0) {
+			place[i] = vehicle[i].place;
+			strncpy(vehicleClass[i], vehicle[i].vehicleClass, sizeof(vehicleClass[i]));
+			changed = true;
+		}
+	}
+	count = n;
+	if (changed) {
+		Rebuild(vehicle, standings);
+	}
+	return changed;
+}
+
+void rfStandingsBuilder::Rebuild(const rfVehicleInfo *vehicle, rfStandings &standings) {
+	memset(standings.overall, 0, sizeof(standings.overall));
+	memset(standings.byClass, 0, sizeof(standings.byClass));
+	memset(standings.classStart, 0, sizeof(standings.classStart));
+	memset(standings.classCount, 0, sizeof(standings.classCount));
+	memset(standings.vehicleClassId, 0, sizeof(standings.vehicleClassId));
+	memset(standings.classPlace, 0, sizeof(standings.classPlace));
+
+	// insertion sort by place, vehicles without one last, ties in slot order
+	for (int i = 0; i < count; i++) {
+		unsigned key = place[i] ? place[i] : 256;
+		int j = i - 1;
+		while (j >= 0 && (place[standings.overall[j]] ? place[standings.overall[j]] : 256) > key) {
+			standings.overall[j + 1] = standings.overall[j];
+			j--;
+		}
+		standings.overall[j + 1] = (unsigned char)i;
+	}
+
+	// classes are numbered as their leaders come up in the overall order,
+	// which also hands out the places within each class in order
+	unsigned char leader[RF_SHARED_MEMORY_MAX_VEHICLES];
+	int classes = 0;
+	for (int p = 0; p < count; p++) {
+		int v = standings.overall[p];
+		int c = 0;
+		while (c < classes && strncmp(vehicleClass[v], vehicleClass[leader[c]], sizeof(vehicleClass[v])) != 0) {
+			c++;
+		}
+		if (c == classes) {
+			leader[classes++] = (unsigned char)v;
+		}
+		standings.vehicleClassId[v] = (unsigned char)c;
+		standings.classPlace[v] = ++standings.classCount[c];
+	}
+	unsigned char next[RF_SHARED_MEMORY_MAX_VEHICLES];
+	for (int c = 0, start = 0; c < classes; c++) {
+		standings.classStart[c] = (unsigned char)start;
+		next[c] = (unsigned char)start;
+		start += standings.classCount[c];
+	}
+	for (int p = 0; p < count; p++) {
+		int v = standings.overall[p];
+		standings.byClass[next[standings.vehicleClassId[v]]++] = (unsigned char)v;
+	}
+
+	standings.numVehicles = count;
+	standings.numClasses = classes;
+	standings.generation = ++generation;
+}
@@ -0,0 +1,61 @@
+/*
+ rfStrings.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ String interning, see rfStrings.hpp.
+*/
+
+#include "rfStrings.hpp"
+#include <atomic>
+#include <string.h>
+
+static_assert((RF_STRINGS_HASH_SIZE & (RF_STRINGS_HASH_SIZE - 1)) == 0 &&
+	RF_STRINGS_HASH_SIZE >= 2 * RF_SHARED_MEMORY_MAX_STRINGS, "RF_STRINGS_HASH_SIZE must be a power of two at least twice the table");
+
+// FNV-1a over the part of s that fits in the table
+static uint32_t Hash(const char *s) {
+	uint32_t h = 2166136261u;
+	for (int i = 0; i < RF_SHARED_MEMORY_STRING_SIZE - 1 && s[i]; i++) {
+		h = (h ^ (unsigned char)s[i]) * 16777619u;
+	}
+	return h;
+}
+
+rfStringInterner::rfStringInterner() {
+	memset(slot, 0, sizeof(slot));
+}
+
+void rfStringInterner::Reset(rfStringTable &table) {
+	memset(slot, 0, sizeof(slot));
+	memset(table.text, 0, sizeof(table.text));
+	table.numStrings = 1;
+}
+
+uint16_t rfStringInterner::Find(const rfStringTable &table, const char *s) const {
+	for (uint32_t h = Hash(s); ; h++) {
+		uint16_t id = slot[h & (RF_STRINGS_HASH_SIZE - 1)];
+		if (id == 0) {
+			return 0;
+		}
+		if (strncmp(table.text[id], s, RF_SHARED_MEMORY_STRING_SIZE - 1) == 0) {
+			return id;
+		}
+	}
+}
+
+uint16_t rfStringInterner::Add(rfStringTable &table, const char *s) {
+	uint32_t id = table.numStrings;
+	if (id >= RF_SHARED_MEMORY_MAX_STRINGS) {
+		return 0;
+	}
+	strncpy(table.text[id], s, RF_SHARED_MEMORY_STRING_SIZE - 1);
+	// readers look ids up without a snapshot, so the text must be there before the count moves past it
+	std::atomic_thread_fence(std::memory_order_release);
+	*(volatile uint32_t*)&table.numStrings = id + 1;
+	uint32_t h = Hash(s);
+	while (slot[h & (RF_STRINGS_HASH_SIZE - 1)] != 0) {
+		h++;
+	}
+	slot[h & (RF_STRINGS_HASH_SIZE - 1)] = (uint16_t)id;
+	return (uint16_t)id;
+}
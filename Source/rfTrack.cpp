@@ -0,0 +1,288 @@
+/*
+ rfTrack.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Track line learner, see rfTrack.hpp.
+*/
+
+#include "rfTrack.hpp"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// atan2 to within 1e-5 radians at a fraction of the cost of atan2f, the
+// heading of every knot a scoring update touched is refreshed on the sim's thread
+static inline float HeadingOf(float x, float z) {
+	float ax = fabsf(x), az = fabsf(z);
+	float hi = ax > az ? ax : az, lo = ax > az ? az : ax;
+	if (hi == 0.0f) {
+		return 0.0f;
+	}
+	float t = lo / hi, t2 = t * t;
+	float a = t * (0.99997726f + t2 * (-0.33262347f + t2 * (0.19354346f + t2 * (-0.11643287f + t2 * (0.05265332f + t2 * -0.01172120f)))));
+	if (ax > az) {
+		a = 1.57079633f - a;
+	}
+	if (z < 0.0f) {
+		a = 3.14159265f - a;
+	}
+	return x < 0.0f ? -a : a;
+}
+
+rfTrackLearner::rfTrackLearner() : length(0.0f), spacing(0.0f), numKnots(0), learned(0), full(true), dirty(false),
+	numPending(0), loaded(false) {
+	memset(name, 0, sizeof(name));
+	memset(knot, 0, sizeof(knot));
+	memset(tangent, 0, sizeof(tangent));
+	memset(marked, 0, sizeof(marked));
+}
+
+rfTrackLearner::~rfTrackLearner() {
+	Stop();
+}
+
+bool rfTrackLearner::Matches(const char *trackName, float lapLength) const {
+	return lapLength == length && strncmp(name, trackName, sizeof(name) - 1) == 0;
+}
+
+// cache file for the current track, with anything but letters and digits in its name replaced
+bool rfTrackLearner::CachePath(char *path, size_t size, const char *dir) const {
+	if (dir == NULL || dir[0] == 0 || numKnots == 0) {
+		return false;
+	}
+	char file[sizeof(name)] = {};
+	for (size_t i = 0; i < sizeof(file) - 1 && name[i]; i++) {
+		char c = name[i];
+		file[i] = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' ? c : '_';
+	}
+	snprintf(path, size, "%s/rfTrack-%s.rftrk", dir, file);
+	return true;
+}
+
+void rfTrackLearner::Reset(const char *trackName, float lapLength, const char *dir) {
+	std::vector<char> saveData;
+	char savePath[1024] = {};
+	if (dirty && CachePath(savePath, sizeof(savePath), dir)) {
+		rfTrackFileHeader header = { RF_TRACK_MAGIC, RF_TRACK_VERSION, numKnots, length, {} };
+		memcpy(header.trackName, name, sizeof(header.trackName));
+		saveData.assign((const char*)&header, (const char*)&header + sizeof(header));
+		saveData.insert(saveData.end(), (const char*)knot, (const char*)(knot + numKnots));
+	}
+
+	memset(name, 0, sizeof(name));
+	strncpy(name, trackName, sizeof(name) - 1);
+	length = lapLength;
+	numKnots = 0;
+	spacing = 0.0f;
+	if (length > 0.0f) {
+		numKnots = (uint32_t)ceilf(length / RF_SHARED_MEMORY_KNOT_SPACING);
+		if (numKnots > RF_SHARED_MEMORY_MAX_KNOTS) {
+			numKnots = RF_SHARED_MEMORY_MAX_KNOTS;
+		}
+		spacing = length / numKnots;
+	}
+	learned = 0;
+	full = true;
+	dirty = false;
+	memset(knot, 0, sizeof(knot));
+	memset(tangent, 0, sizeof(tangent));
+	memset(marked, 0, sizeof(marked));
+	numPending = 0;
+
+	char loadPath[1024] = {};
+	CachePath(loadPath, sizeof(loadPath), dir);
+	Start(savePath, saveData, loadPath);
+}
+
+void rfTrackLearner::Save(const char *dir) {
+	char savePath[1024] = {};
+	if (!dirty || !CachePath(savePath, sizeof(savePath), dir)) {
+		return;
+	}
+	rfTrackFileHeader header = { RF_TRACK_MAGIC, RF_TRACK_VERSION, numKnots, length, {} };
+	memcpy(header.trackName, name, sizeof(header.trackName));
+	std::vector<char> saveData((const char*)&header, (const char*)&header + sizeof(header));
+	saveData.insert(saveData.end(), (const char*)knot, (const char*)(knot + numKnots));
+	dirty = false;
+	Start(savePath, saveData, "");
+}
+
+void rfTrackLearner::Stop() {
+	if (io.joinable()) {
+		io.join();
+	}
+}
+
+void rfTrackLearner::Start(const std::string &savePath, std::vector<char> &saveData, const std::string &loadPath) {
+	// the previous save or load has long finished by the time the track changes
+	Stop();
+	loaded.store(false, std::memory_order_relaxed);
+	cache.clear();
+	if (savePath.empty() && loadPath.empty()) {
+		return;
+	}
+	rfTrackFileHeader expected = { RF_TRACK_MAGIC, RF_TRACK_VERSION, numKnots, length, {} };
+	memcpy(expected.trackName, name, sizeof(expected.trackName));
+	io = std::thread(&rfTrackLearner::Run, this, savePath, std::move(saveData), loadPath, expected);
+}
+
+void rfTrackLearner::Run(std::string savePath, std::vector<char> saveData, std::string loadPath, rfTrackFileHeader expected) {
+	if (!savePath.empty()) {
+		FILE *f = fopen(savePath.c_str(), "wb");
+		if (f) {
+			fwrite(saveData.data(), saveData.size(), 1, f);
+			fclose(f);
+		}
+	}
+	if (loadPath.empty()) {
+		return;
+	}
+	FILE *f = fopen(loadPath.c_str(), "rb");
+	if (f == NULL) {
+		return;
+	}
+	// a line learned at another lap length would put every knot in the wrong place
+	rfTrackFileHeader header;
+	if (fread(&header, sizeof(header), 1, f) == 1 && header.magic == expected.magic && header.version == expected.version &&
+		header.numKnots == expected.numKnots && header.length == expected.length &&
+		strncmp(header.trackName, expected.trackName, sizeof(header.trackName)) == 0) {
+		cache.resize(header.numKnots);
+		if (fread(cache.data(), sizeof(rfTrackKnot), cache.size(), f) == cache.size()) {
+			loaded.store(true, std::memory_order_release);
+		}
+	}
+	fclose(f);
+}
+
+void rfTrackLearner::Merge() {
+	Stop();
+	loaded.store(false, std::memory_order_relaxed);
+	if (cache.size() != numKnots) {
+		return;
+	}
+	learned = 0;
+	for (uint32_t k = 0; k < numKnots; k++) {
+		rfTrackKnot &n = knot[k];
+		const rfTrackKnot &c = cache[k];
+		float total = n.weight + c.weight;
+		if (total > 0.0f) {
+			float a = c.weight / total;
+			n.pos.x += (c.pos.x - n.pos.x) * a;
+			n.pos.y += (c.pos.y - n.pos.y) * a;
+			n.pos.z += (c.pos.z - n.pos.z) * a;
+			n.weight = total;
+			learned++;
+		}
+	}
+	cache.clear();
+	// aim the whole line now, so the cached samples aren't taken for first guesses
+	for (uint32_t k = 0; k < numKnots; k++) {
+		Aim(k);
+	}
+	full = true;
+}
+
+// heading of knot k and the tangent to slide its samples along
+void rfTrackLearner::Aim(uint32_t k) {
+	// tangent from the learned neighbours, or from this knot to the one learned neighbour
+	const rfTrackKnot &prev = knot[k > 0 ? k - 1 : numKnots - 1];
+	const rfTrackKnot &next = knot[k + 1 < numKnots ? k + 1 : 0];
+	const rfTrackKnot &a = prev.weight > 0.0f ? prev : knot[k];
+	const rfTrackKnot &b = next.weight > 0.0f ? next : knot[k];
+	float tx = b.pos.x - a.pos.x, ty = b.pos.y - a.pos.y, tz = b.pos.z - a.pos.z;
+	float len = sqrtf(tx * tx + ty * ty + tz * tz);
+	if (knot[k].weight > 0.0f && len > 0.0f) {
+		knot[k].heading = HeadingOf(tx, tz);
+		// only a tangent between two learned neighbours is good enough to slide samples along
+		float s = prev.weight > 0.0f && next.weight > 0.0f ? 1.0f / len : 0.0f;
+		tangent[k].x = tx * s;
+		tangent[k].y = ty * s;
+		tangent[k].z = tz * s;
+	}
+}
+
+void rfTrackLearner::Touch(uint32_t k) {
+	if (!marked[k]) {
+		marked[k] = true;
+		pending[numPending++] = (uint16_t)k;
+	}
+}
+
+void rfTrackLearner::Add(float lapDist, const rfVec3 &pos) {
+	if (loaded.load(std::memory_order_acquire)) {
+		Merge();
+	}
+	if (numKnots == 0 || !(lapDist >= 0.0f && lapDist < length)) {
+		return;
+	}
+	float u = lapDist / spacing;
+	uint32_t k0 = (uint32_t)u;
+	float f = u - (float)k0;
+	if (k0 >= numKnots) {
+		k0 = numKnots - 1;
+		f = 1.0f;
+	}
+	uint32_t k[2] = { k0, k0 + 1 < numKnots ? k0 + 1 : 0 };
+	float w[2] = { 1.0f - f, f };
+	float offset[2] = { -f * spacing, (1.0f - f) * spacing };
+	for (int i = 0; i < 2; i++) {
+		if (w[i] <= 0.0f) {
+			continue;
+		}
+		rfTrackKnot &n = knot[k[i]];
+		if (n.weight >= RF_TRACK_MAX_WEIGHT) {
+			continue;
+		}
+		// slide the sample along the line to the knot's lapDist once the line
+		// there is known, so samples landing unevenly between knots don't bias it
+		const rfVec3 &t = tangent[k[i]];
+		rfVec3 p = { pos.x + t.x * offset[i], pos.y + t.y * offset[i], pos.z + t.z * offset[i] };
+		float total = n.weight + w[i];
+		float a = w[i] / total;
+		n.pos.x += (p.x - n.pos.x) * a;
+		n.pos.y += (p.y - n.pos.y) * a;
+		n.pos.z += (p.z - n.pos.z) * a;
+		if (n.weight == 0.0f) {
+			learned++;
+		}
+		n.weight = total;
+		// the neighbours' tangents move with this knot too, but by so little once
+		// the line has settled that they wait for samples of their own
+		Touch(k[i]);
+	}
+	dirty = true;
+}
+
+void rfTrackLearner::Flush(rfTrackSegment &seg) {
+	if (loaded.load(std::memory_order_acquire)) {
+		Merge();
+	}
+	if (full) {
+		numPending = 0;
+		memset(marked, 0, sizeof(marked));
+		for (uint32_t k = 0; k < numKnots; k++) {
+			Touch(k);
+		}
+		memcpy(seg.trackName, name, sizeof(seg.trackName));
+		seg.numKnots = numKnots;
+		seg.length = length;
+		seg.spacing = spacing;
+		memset(seg.knot + numKnots, 0, (RF_SHARED_MEMORY_MAX_KNOTS - numKnots) * sizeof(rfTrackKnot));
+		full = false;
+	}
+	for (uint32_t i = 0; i < numPending; i++) {
+		uint32_t k = pending[i];
+		marked[k] = false;
+		rfVec3 &t = tangent[k];
+		bool aimed = t.x != 0.0f || t.y != 0.0f || t.z != 0.0f;
+		Aim(k);
+		// samples taken before there was a tangent to slide them along were only
+		// a first guess, so they count as one between them once there is
+		if (!aimed && (t.x != 0.0f || t.y != 0.0f || t.z != 0.0f) && knot[k].weight > 1.0f) {
+			knot[k].weight = 1.0f;
+		}
+		seg.knot[k] = knot[k];
+	}
+	numPending = 0;
+	seg.learned = learned;
+}
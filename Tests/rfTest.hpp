@@ -0,0 +1,36 @@
+/*
+rfTest.hpp
+by Dan Allongo (daniel.s.allongo@gmail.com)
+
+Minimal checks for the programs in Tests/. Each test is a program of its own
+that prints the checks that failed and exits non-zero if there were any
+(make test in the Linux build runs them all).
+*/
+
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+
+static int rfTestFailures = 0;
+
+#define RF_CHECK(cond) do { \
+	if (!(cond)) { \
+		fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+		rfTestFailures++; \
+	} \
+} while (0)
+
+#define RF_CHECK_NEAR(a, b, eps) do { \
+	double rfCheckA = (a), rfCheckB = (b); \
+	if (!(fabs(rfCheckA - rfCheckB) <= (eps))) { \
+		fprintf(stderr, "%s:%d: check failed: %s = %g, %s = %g (within %g)\n", __FILE__, __LINE__, #a, rfCheckA, #b, rfCheckB, (double)(eps)); \
+		rfTestFailures++; \
+	} \
+} while (0)
+
+// what main returns
+static inline int rfTestResult(const char *name) {
+	printf("%s: %s\n", name, rfTestFailures ? "FAILED" : "passed");
+	return rfTestFailures ? 1 : 0;
+}
@@ -0,0 +1,131 @@
+/*
+ rfTestArchive.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Records a few laps into an archive and seeks back to every lap and sector.
+ Telemetry runs at 90 Hz and scoring at 2 Hz like the sim, so the telemetry
+ lap number turns over up to half a second before scoring's sector does.
+
+ usage: rfTestArchive capture.rfcap (the archive is written next to it)
+*/
+
+#include "rfArchive.hpp"
+#include "rfTest.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define CARS 4
+#define LAPS 4
+#define LAP_TIME 12.0                // seconds
+#define TRACK_LENGTH 1200.0f
+
+static std::vector<char> scoringBuf(sizeof(rfCaptureScoring) + CARS * sizeof(rfCaptureVehicle));
+
+// where the player is at t, lap counting from 1
+static void Player(double t, int &lap, float &dist) {
+	lap = (int)(t / LAP_TIME) + 1;
+	dist = (float)(t - (lap - 1) * LAP_TIME) / (float)LAP_TIME * TRACK_LENGTH;
+}
+
+static void WriteRecord(rfArchiveWriter &writer, unsigned int type, double t, const void *payload, size_t size) {
+	rfCaptureRecord record = { type, (unsigned int)size, t };
+	RF_CHECK(writer.Write(record, payload));
+}
+
+static void WriteScoring(rfArchiveWriter &writer, double t) {
+	rfCaptureScoring *info = (rfCaptureScoring*)scoringBuf.data();
+	rfCaptureVehicle *veh = (rfCaptureVehicle*)(scoringBuf.data() + sizeof(rfCaptureScoring));
+	memset(scoringBuf.data(), 0, scoringBuf.size());
+	info->mCurrentET = (float)t;
+	info->mLapDist = TRACK_LENGTH;
+	info->mNumVehicles = CARS;
+	for (int i = 0; i < CARS; i++) {
+		int lap;
+		float dist;
+		Player(t + i, lap, dist);
+		veh[i].mIsPlayer = (i == 0);
+		veh[i].mTotalLaps = (short)(lap - 1);
+		veh[i].mLapDist = dist;
+		veh[i].mSector = dist < TRACK_LENGTH / 3.0f ? 1 : dist < TRACK_LENGTH * 2.0f / 3.0f ? 2 : 0;
+	}
+	WriteRecord(writer, captureScoring, t, scoringBuf.data(), scoringBuf.size());
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s capture.rfcap\n", argv[0]);
+		return 1;
+	}
+	std::string path = std::string(argv[1]) + ".rfarc";
+	rfCaptureHeader header = rfCaptureMakeHeader();
+
+	// record: one session, telemetry every tick and scoring every 45th
+	rfArchiveWriter writer;
+	RF_CHECK(writer.Open(path.c_str(), header, 1000.0));
+	WriteRecord(writer, captureStartSession, 0.0, NULL, 0);
+	WriteRecord(writer, captureEnterRealtime, 0.0, NULL, 0);
+	rfCaptureTelem telem;
+	memset(&telem, 0, sizeof(telem));
+	for (int tick = 0; tick < (int)(LAPS * LAP_TIME * 90.0); tick++) {
+		double t = tick / 90.0;
+		if (tick % 45 == 0) {
+			WriteScoring(writer, t);
+		}
+		float dist;
+		int lap;
+		Player(t, lap, dist);
+		telem.mLapNumber = lap;
+		telem.mDeltaTime = 1.0f / 90.0f;
+		WriteRecord(writer, captureTelemetry, t, &telem, sizeof(telem));
+	}
+	WriteRecord(writer, captureExitRealtime, LAPS * LAP_TIME, NULL, 0);
+	WriteRecord(writer, captureEndSession, LAPS * LAP_TIME, NULL, 0);
+	RF_CHECK(writer.Close());
+
+	rfArchiveReader reader;
+	RF_CHECK(reader.Open(path.c_str()));
+
+	// the index runs through the laps and sectors in order
+	const std::vector<rfArchiveIndexEntry> &index = reader.Index();
+	RF_CHECK(index.size() >= LAPS * 3);
+	for (size_t i = 1; i < index.size(); i++) {
+		RF_CHECK(index[i].lap > index[i - 1].lap || (index[i].lap == index[i - 1].lap && index[i].sector >= index[i - 1].sector));
+	}
+
+	// every lap and sector seeks to the scoring update it started on
+	for (int lap = 1; lap <= LAPS; lap++) {
+		for (int sector = 1; sector <= 3; sector++) {
+			RF_CHECK(reader.SeekLap(0, lap, sector));
+			const rfArchiveState &state = reader.State();
+			RF_CHECK(state.lap == lap);
+			RF_CHECK(state.sector == sector);
+			RF_CHECK(state.scoring.size() == scoringBuf.size());
+			if (state.scoring.size() != scoringBuf.size()) {
+				continue;
+			}
+			const rfCaptureVehicle &player = *(const rfCaptureVehicle*)(state.scoring.data() + sizeof(rfCaptureScoring));
+			RF_CHECK(player.mTotalLaps + 1 == lap);
+			RF_CHECK((player.mSector ? player.mSector : 3) == sector);
+			// the keyframe is written right after that scoring record
+			RF_CHECK(state.time == state.scoringTime);
+			int expectLap;
+			float dist;
+			Player(state.scoringTime, expectLap, dist);
+			RF_CHECK(dist < TRACK_LENGTH * sector / 3.0f && dist + TRACK_LENGTH / 3.0f >= TRACK_LENGTH * sector / 3.0f);
+
+			// and reading on from there carries on where the recording did
+			rfCaptureRecord record;
+			const void *payload;
+			RF_CHECK(reader.Next(record, payload));
+			RF_CHECK(record.type == captureTelemetry && record.time >= state.scoringTime);
+		}
+	}
+	// a lap that was never driven lands on the last keyframe before it
+	RF_CHECK(reader.SeekLap(0, LAPS + 1, 1));
+	RF_CHECK(reader.State().lap == LAPS && reader.State().sector == 3);
+	reader.Close();
+	remove(path.c_str());
+	return rfTestResult("rfTestArchive");
+}
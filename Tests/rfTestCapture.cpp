@@ -0,0 +1,96 @@
+/*
+ rfTestCapture.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Checks the capture payloads are laid out like the 32-bit sim's structs, and
+ that the sim's structs survive a trip through them on this build.
+*/
+
+#include "rfCapture.hpp"
+#include "rfTest.hpp"
+#include <string.h>
+
+// fill a struct with bytes that differ from member to member
+static void Pattern(void *p, size_t size, int seed) {
+	for (size_t i = 0; i < size; i++) {
+		((unsigned char*)p)[i] = (unsigned char)(i * 7 + seed);
+	}
+}
+
+static size_t Offset(const void *base, const void *member) {
+	return (size_t)((const char*)member - (const char*)base);
+}
+
+int main() {
+	// offsets of the members either side of a long or pointer in the 32-bit sim
+	// (measured on instances, offsetof isn't defined for the derived structs)
+	rfCaptureTelem t;
+	rfCaptureVehicle v;
+	rfCaptureScoring s;
+	RF_CHECK(Offset(&t, &t.mGear) == 236);
+	RF_CHECK(Offset(&t, &t.mFuel) == 276);
+	RF_CHECK(Offset(&t, &t.mWheel) == 380);
+	RF_CHECK(Offset(&v, &v.mLapsBehindNext) == 188);
+	RF_CHECK(Offset(&v, &v.mPos) == 204);
+	RF_CHECK(Offset(&s, &s.mNumVehicles) == 88);
+	RF_CHECK(Offset(&s, &s.mGamePhase) == 92);
+	RF_CHECK(Offset(&s, &s.mVehicle) == 488);
+
+	TelemInfoV2 telem, telemBack;
+	Pattern(&telem, sizeof(telem), 1);
+	telem.mLapNumber = 37;
+	telem.mGear = -1;
+	rfCaptureTelem capturedTelem;
+	rfCaptureFromTelem(telem, capturedTelem);
+	rfCaptureToTelem(capturedTelem, telemBack);
+	RF_CHECK(capturedTelem.mLapNumber == 37 && capturedTelem.mGear == -1);
+	RF_CHECK(memcmp(&telemBack.mDeltaTime, &telem.mDeltaTime, sizeof(float)) == 0);
+	RF_CHECK(telemBack.mLapNumber == 37 && telemBack.mGear == -1);
+	RF_CHECK(memcmp(telemBack.mVehicleName, telem.mVehicleName, sizeof(telem.mVehicleName)) == 0);
+	RF_CHECK(memcmp(&telemBack.mLocalRotAccel, &telem.mLocalRotAccel, sizeof(telem.mLocalRotAccel)) == 0);
+	RF_CHECK(memcmp(&telemBack.mEngineRPM, &telem.mEngineRPM, sizeof(float)) == 0);
+	RF_CHECK(memcmp(&telemBack.mSteeringArmForce, &telem.mSteeringArmForce, sizeof(float)) == 0);
+	RF_CHECK(memcmp(&telemBack.mFuel, &telem.mFuel, sizeof(float)) == 0);
+	RF_CHECK(memcmp(telemBack.mDentSeverity, telem.mDentSeverity, sizeof(telem.mDentSeverity)) == 0);
+	RF_CHECK(memcmp(telemBack.mWheel, telem.mWheel, sizeof(telem.mWheel)) == 0);
+
+	VehicleScoringInfoV2 veh, vehBack;
+	Pattern(&veh, sizeof(veh), 2);
+	veh.mLapsBehindNext = 2;
+	veh.mLapsBehindLeader = -3;
+	rfCaptureVehicle capturedVeh;
+	rfCaptureFromVehicle(veh, capturedVeh);
+	rfCaptureToVehicle(capturedVeh, vehBack);
+	RF_CHECK(capturedVeh.mLapsBehindNext == 2 && capturedVeh.mLapsBehindLeader == -3);
+	RF_CHECK(memcmp(vehBack.mDriverName, veh.mDriverName, sizeof(veh.mDriverName)) == 0);
+	RF_CHECK(vehBack.mTotalLaps == veh.mTotalLaps && vehBack.mSector == veh.mSector);
+	RF_CHECK(vehBack.mNumPenalties == veh.mNumPenalties && vehBack.mPlace == veh.mPlace);
+	RF_CHECK(memcmp(vehBack.mVehicleClass, veh.mVehicleClass, sizeof(veh.mVehicleClass)) == 0);
+	RF_CHECK(memcmp(&vehBack.mTimeBehindNext, &veh.mTimeBehindNext, sizeof(float)) == 0);
+	RF_CHECK(memcmp(&vehBack.mTimeBehindLeader, &veh.mTimeBehindLeader, sizeof(float)) == 0);
+	RF_CHECK(vehBack.mLapsBehindNext == 2 && vehBack.mLapsBehindLeader == -3);
+	RF_CHECK(memcmp(&vehBack.mPos, &veh.mPos, sizeof(veh.mPos)) == 0);
+	RF_CHECK(memcmp(&vehBack.mLocalRotAccel, &veh.mLocalRotAccel, sizeof(veh.mLocalRotAccel)) == 0);
+	RF_CHECK(memcmp(vehBack.mExpansion, veh.mExpansion, sizeof(veh.mExpansion)) == 0);
+
+	ScoringInfoV2 scoring, scoringBack;
+	Pattern(&scoring, sizeof(scoring), 3);
+	scoring.mSession = 10;
+	scoring.mMaxLaps = 50;
+	scoring.mNumVehicles = 1;
+	scoring.mVehicle = &veh;
+	rfCaptureScoring capturedScoring;
+	rfCaptureFromScoring(scoring, capturedScoring);
+	rfCaptureToScoring(capturedScoring, scoringBack);
+	RF_CHECK(capturedScoring.mVehicle == 0 && capturedScoring.mResultsStream == 0);
+	RF_CHECK(memcmp(scoringBack.mTrackName, scoring.mTrackName, sizeof(scoring.mTrackName)) == 0);
+	RF_CHECK(scoringBack.mSession == 10 && scoringBack.mMaxLaps == 50 && scoringBack.mNumVehicles == 1);
+	RF_CHECK(memcmp(&scoringBack.mCurrentET, &scoring.mCurrentET, sizeof(float)) == 0);
+	RF_CHECK(memcmp(&scoringBack.mLapDist, &scoring.mLapDist, sizeof(float)) == 0);
+	RF_CHECK(scoringBack.mGamePhase == scoring.mGamePhase && scoringBack.mInRealtime == scoring.mInRealtime);
+	RF_CHECK(memcmp(scoringBack.mPlrFileName, scoring.mPlrFileName, sizeof(scoring.mPlrFileName)) == 0);
+	RF_CHECK(memcmp(&scoringBack.mWind, &scoring.mWind, sizeof(scoring.mWind)) == 0);
+	RF_CHECK(memcmp(scoringBack.mExpansion, scoring.mExpansion, sizeof(scoring.mExpansion)) == 0);
+	RF_CHECK(scoringBack.mVehicle == NULL && scoringBack.mResultsStream == NULL);
+	return rfTestResult("rfTestCapture");
+}
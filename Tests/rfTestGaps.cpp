@@ -0,0 +1,82 @@
+/*
+ rfTestGaps.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Drives rfGapEngine with a field that all follow the same speed profile a
+ fixed time apart, so the true time gap between neighbours is that spacing
+ wherever they are, even though distance over speed isn't.
+*/
+
+#include "rfGaps.hpp"
+#include "rfTest.hpp"
+#include <math.h>
+#include <stdio.h>
+
+#define CARS 8
+#define SPACING 2.0                  // seconds between consecutive cars
+#define LENGTH 2000.0f
+#define MAX_GAP_ERROR 0.011          // seconds
+
+static rfGapEngine gaps;
+
+// distance covered after t seconds, speed swinging between 30 and 70 m/s
+static double Distance(double t) {
+	return 50.0 * t + 20.0 / 0.7 * sin(0.7 * t);
+}
+
+static double Speed(double t) {
+	return 50.0 + 20.0 * cos(0.7 * t);
+}
+
+// one update at session time et, with the cars placed as of time t
+static void Update(double t, float et) {
+	float lapDist[CARS], speed[CARS];
+	for (int i = 0; i < CARS; i++) {
+		double d = Distance(t - i * SPACING);
+		lapDist[i] = (float)(d - floor(d / LENGTH) * LENGTH);
+		speed[i] = (float)Speed(t - i * SPACING);
+	}
+	gaps.Update(lapDist, speed, CARS, LENGTH, et);
+}
+
+// worst error in timeAhead of every car but the leader, which closes the loop a lap down
+static double WorstError() {
+	double worst = 0.0;
+	for (int i = 1; i < CARS; i++) {
+		RF_CHECK(gaps.ahead[i] == i - 1 && gaps.behind[i - 1] == i);
+		worst = fmax(worst, fabs(gaps.timeAhead[i] - SPACING));
+	}
+	return worst;
+}
+
+int main() {
+	const double start = 20.0, lap = LENGTH / 50.0;
+	// two laps to see every car pass every mark, then a lap checked at the telemetry rate
+	double worst = 0.0, fallback = 0.0;
+	for (int tick = 0; tick < (int)(3.0 * lap * 90.0); tick++) {
+		double t = start + tick / 90.0;
+		// like the plugin's currentET, which lags a little when a scoring update
+		// arrives and so steps back a few ms from the last extrapolated value
+		bool scoring = tick % 45 == 0;
+		float et = (float)(scoring ? t - 0.015 : t);
+		Update(t, et);
+		if (t - start > 2.0 * lap && !scoring) {
+			worst = fmax(worst, WorstError());
+			for (int i = 1; i < CARS; i++) {
+				fallback = fmax(fallback, fabs(gaps.distanceAhead[i] / Speed(t - i * SPACING) - SPACING));
+			}
+		}
+	}
+	printf("time gaps within %.1f ms of the true gap, distance over speed within %.0f ms\n", worst * 1e3, fallback * 1e3);
+	RF_CHECK(worst <= MAX_GAP_ERROR);
+	RF_CHECK(fallback > worst);
+
+	// a restart goes back further than a step, and only distance over speed is left
+	double t = start + 3.0 * lap;
+	Update(t, (float)(start + 3.0 * lap - 10.0));
+	Update(t + 1.0 / 90.0, (float)(start + 3.0 * lap - 10.0 + 1.0 / 90.0));
+	for (int i = 1; i < CARS; i++) {
+		RF_CHECK_NEAR(gaps.timeAhead[i], gaps.distanceAhead[i] / Speed(t + 1.0 / 90.0 - i * SPACING), 1e-3);
+	}
+	return rfTestResult("rfTestGaps");
+}
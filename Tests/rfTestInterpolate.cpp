@@ -0,0 +1,157 @@
+/*
+ rfTestInterpolate.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Checks the Rodrigues orientation integrator against the per-axis z/y/x one
+ it replaced, on every scoring update of a capture (made by rfReplay with
+ RFSHARED_RECORD_DIR set, see make test).
+
+ usage: rfTestInterpolate capture.rfcap
+*/
+
+#include "rfInterpolateKernel.hpp"
+#include "rfCapture.hpp"
+#include "rfTest.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define DELTA 0.02f                  // seconds extrapolated, about two telemetry ticks
+#define MAX_ANGLE_ERROR 2e-5         // rad the two may differ by at DELTA
+
+// the old integrator: rotate each orientation row about z, then y, then x,
+// then renormalize it
+template <class V>
+static void RotateZYX(V &vx, V &vy, V &vz, const V &sx, const V &cx, const V &sy, const V &cy, const V &sz, const V &cz) {
+	V zx = vx * cz + vy * sz;
+	V zy = vy * cz - vx * sz;
+	V yx = zx * cy - vz * sy;
+	V yz = vz * cy + zx * sy;
+	vx = yx;
+	vy = zy * cx + yz * sx;
+	vz = yz * cx - zy * sx;
+}
+
+template <class V>
+static void Normalize(V &vx, V &vy, V &vz) {
+	V len = rfSqrt(vx * vx + vy * vy + vz * vz);
+	auto valid = len > V::set(0.0f);
+	vx = rfSelect(valid, vx / len, vx);
+	vy = rfSelect(valid, vy / len, vy);
+	vz = rfSelect(valid, vz / len, vz);
+}
+
+// orientation part of rfInterpolateKernel as it was before the Rodrigues rotation
+template <class V>
+static void ReferenceKernel(const rfVehicleStateSoA &in, int count, float delta, rfVehicleInterpSoA &out) {
+	const V accStep = V::set(delta * RF_SHARED_MEMORY_ACC_SMOOTH_FACTOR);
+	const V rotStep = V::set(delta * RF_SHARED_MEMORY_ROT_SMOOTH_FACTOR);
+	for (int i = 0; i < count; i += V::width) {
+		V rotX = V::load(&in.localRot.x[i]) + V::load(&in.localRotAccel.x[i]) * accStep;
+		V rotY = V::load(&in.localRot.y[i]) + V::load(&in.localRotAccel.y[i]) * accStep;
+		V rotZ = V::load(&in.localRot.z[i]) + V::load(&in.localRotAccel.z[i]) * accStep;
+
+		V xx = V::load(&in.oriX.x[i]), xy = V::load(&in.oriX.y[i]), xz = V::load(&in.oriX.z[i]);
+		V yx = V::load(&in.oriY.x[i]), yy = V::load(&in.oriY.y[i]), yz = V::load(&in.oriY.z[i]);
+		V zx = V::load(&in.oriZ.x[i]), zy = V::load(&in.oriZ.y[i]), zz = V::load(&in.oriZ.z[i]);
+
+		V sx, cx, sy, cy, sz, cz;
+		rfSinCos((xx * rotX + xy * rotY + xz * rotZ) * rotStep, sx, cx);
+		rfSinCos((yx * rotX + yy * rotY + yz * rotZ) * rotStep, sy, cy);
+		rfSinCos((zx * rotX + zy * rotY + zz * rotZ) * rotStep, sz, cz);
+
+		RotateZYX(xx, xy, xz, sx, cx, sy, cy, sz, cz);
+		RotateZYX(yx, yy, yz, sx, cx, sy, cy, sz, cz);
+		RotateZYX(zx, zy, zz, sx, cx, sy, cy, sz, cz);
+		Normalize(xx, xy, xz);
+		Normalize(yx, yy, yz);
+		Normalize(zx, zy, zz);
+
+		rfAtan2(zx, zz).store(&out.yaw[i]);
+		rfAtan2(V::set(0.0f) - yz, rfSqrt(xz * xz + zz * zz)).store(&out.pitch[i]);
+		rfAtan2(yx, rfSqrt(xx * xx + zx * zx)).store(&out.roll[i]);
+	}
+}
+
+static void SetSoA(rfVec3SoA &soa, int i, const TelemVect3 &v) {
+	soa.x[i] = v.x;
+	soa.y[i] = v.y;
+	soa.z[i] = v.z;
+}
+
+// difference between two angles, wrapped into [-pi, pi]
+static double AngleError(float a, float b) {
+	double d = fmod((double)a - b, 2.0 * 3.14159265358979);
+	if (d > 3.14159265358979) {
+		d -= 2.0 * 3.14159265358979;
+	} else if (d < -3.14159265358979) {
+		d += 2.0 * 3.14159265358979;
+	}
+	return fabs(d);
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s capture.rfcap\n", argv[0]);
+		return 1;
+	}
+	FILE *f = fopen(argv[1], "rb");
+	RF_CHECK(f != NULL);
+	if (f == NULL) {
+		return rfTestResult("rfTestInterpolate");
+	}
+	rfCaptureHeader header;
+	RF_CHECK(fread(&header, sizeof(header), 1, f) == 1 && rfCaptureCompatible(header));
+
+	static rfVehicleStateSoA in;
+	static rfVehicleInterpSoA reference, scalar, selected;
+	const rfInterpolateFunc interpolate = rfSelectInterpolate();
+	double maxError = 0.0;
+	int updates = 0, vehicles = 0;
+	rfCaptureRecord record;
+	std::vector<char> payload;
+	while (fread(&record, sizeof(record), 1, f) == 1) {
+		payload.resize(record.size);
+		if (record.size > 0 && fread(payload.data(), record.size, 1, f) != 1) {
+			break;
+		}
+		if (record.type != captureScoring) {
+			continue;
+		}
+		const rfCaptureScoring &info = *(const rfCaptureScoring*)payload.data();
+		const rfCaptureVehicle *veh = (const rfCaptureVehicle*)(payload.data() + sizeof(rfCaptureScoring));
+		int count = info.mNumVehicles < RF_SHARED_MEMORY_MAX_VEHICLES ? (int)info.mNumVehicles : RF_SHARED_MEMORY_MAX_VEHICLES;
+		memset(&in, 0, sizeof(in));
+		for (int i = 0; i < count; i++) {
+			in.lapDist[i] = veh[i].mLapDist;
+			SetSoA(in.pos, i, veh[i].mPos);
+			SetSoA(in.localVel, i, veh[i].mLocalVel);
+			SetSoA(in.localAccel, i, veh[i].mLocalAccel);
+			SetSoA(in.oriX, i, veh[i].mOriX);
+			SetSoA(in.oriY, i, veh[i].mOriY);
+			SetSoA(in.oriZ, i, veh[i].mOriZ);
+			SetSoA(in.localRot, i, veh[i].mLocalRot);
+			SetSoA(in.localRotAccel, i, veh[i].mLocalRotAccel);
+		}
+		ReferenceKernel<rfFloat1>(in, count, DELTA, reference);
+		rfInterpolateScalar(in, count, DELTA, scalar);
+		interpolate(in, count, DELTA, selected);
+		for (int i = 0; i < count; i++) {
+			const rfVehicleInterpSoA *out[2] = { &scalar, &selected };
+			for (int k = 0; k < 2; k++) {
+				double e = AngleError(out[k]->yaw[i], reference.yaw[i]);
+				e = fmax(e, AngleError(out[k]->pitch[i], reference.pitch[i]));
+				e = fmax(e, AngleError(out[k]->roll[i], reference.roll[i]));
+				maxError = fmax(maxError, e);
+			}
+		}
+		updates++;
+		vehicles += count;
+	}
+	fclose(f);
+
+	printf("%d scoring updates, %d vehicles, max difference %.2g rad at %g s\n", updates, vehicles, maxError, DELTA);
+	RF_CHECK(updates > 0);
+	RF_CHECK(maxError <= MAX_ANGLE_ERROR);
+	return rfTestResult("rfTestInterpolate");
+}
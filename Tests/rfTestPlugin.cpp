@@ -0,0 +1,154 @@
+/*
+ rfTestPlugin.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Drives the plugin through a scoring and a few telemetry updates against heap
+ maps (rfPlatformHeap.cpp) and checks what a reader of the main map sees. The
+ vehicle segment is configured smaller than the field, which must not cost
+ the main map any vehicles.
+*/
+
+#include "rFactorSharedMemoryMap.hpp"
+#include "rfSharedReader.hpp"
+#include "rfTest.hpp"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#define CARS 8
+#define CAPACITY 4                   // RFSHARED_VEHICLES, fewer than CARS
+
+// cars spread around a 4 km circle, as in rfReplay's synthetic session
+static void MakeScoring(std::vector<char> &buf, ScoringInfoV2 *&info, float et) {
+	const float trackLength = 4000.0f;
+	const float radius = trackLength / (2.0f * 3.14159265f);
+	buf.assign(sizeof(ScoringInfoV2) + CARS * sizeof(VehicleScoringInfoV2), 0);
+	info = (ScoringInfoV2*)buf.data();
+	VehicleScoringInfoV2 *veh = (VehicleScoringInfoV2*)(buf.data() + sizeof(ScoringInfoV2));
+	strcpy(info->mTrackName, "Synthetic Oval");
+	strcpy(info->mPlayerName, "Player");
+	info->mCurrentET = et;
+	info->mLapDist = trackLength;
+	info->mNumVehicles = CARS;
+	info->mGamePhase = 5;
+	info->mVehicle = veh;
+	for (int i = 0; i < CARS; i++) {
+		float speed = 50.0f;
+		float dist = trackLength - i * (trackLength / CARS);
+		float angle = dist / radius;
+		VehicleScoringInfoV2 &v = veh[i];
+		sprintf(v.mDriverName, "Driver %d", i + 1);
+		strcpy(v.mVehicleClass, "GT1");
+		v.mIsPlayer = (i == 0);
+		v.mPlace = (unsigned char)(i + 1);
+		v.mLapDist = dist;
+		v.mPos.Set(radius * sinf(angle), 0.0f, radius * cosf(angle));
+		v.mOriX.Set(cosf(angle), 0.0f, -sinf(angle));
+		v.mOriY.Set(0.0f, 1.0f, 0.0f);
+		v.mOriZ.Set(sinf(angle), 0.0f, cosf(angle));
+		v.mLocalVel.Set(0.0f, 0.0f, -speed);
+		v.mLocalRot.Set(0.0f, speed / radius, 0.0f);
+	}
+}
+
+int main() {
+	setenv(PLUGIN_VEHICLES_VAR, "4", 1);
+	SharedMemoryMapPlugin plugin;
+	plugin.Startup();
+	plugin.StartSession();
+	plugin.EnterRealtime();
+	char tag[256];
+	rfMapName(tag, sizeof(tag), RF_SHARED_MEMORY_NAME);
+	rfMapping readerMap;
+	rfShared *map = (rfShared*)rfMapCreate(readerMap, tag, sizeof(rfShared));
+	RF_CHECK(map != NULL);
+	if (map == NULL) {
+		return rfTestResult("rfTestPlugin");
+	}
+	std::vector<rfShared> copy(1);
+	rfShared &snap = copy[0];
+
+	std::vector<char> buf;
+	ScoringInfoV2 *info;
+	MakeScoring(buf, info, 10.0f);
+	plugin.UpdateScoring(*info);
+	RF_CHECK(rfSharedSnapshot(map, &snap));
+	RF_CHECK((snap.sequence & 1) == 0);
+	RF_CHECK(strcmp(snap.version, RF_SHARED_MEMORY_VERSION) == 0);
+	RF_CHECK(snap.numVehicles == CARS);
+	RF_CHECK(snap.deltaTime == 0.0f);
+	for (int i = 0; i < CARS; i++) {
+		char name[32];
+		sprintf(name, "Driver %d", i + 1);
+		RF_CHECK(strcmp(snap.vehicle[i].driverName, name) == 0);
+		RF_CHECK(snap.vehicle[i].place == i + 1);
+		// raw scoring values while deltaTime == 0
+		RF_CHECK(snap.vehicle[i].lapDist == info->mVehicle[i].mLapDist);
+		RF_CHECK(snap.vehicle[i].pos.x == info->mVehicle[i].mPos.x);
+		RF_CHECK(snap.vehicle[i].pos.z == info->mVehicle[i].mPos.z);
+		RF_CHECK_NEAR(snap.vehicle[i].speed, 50.0, 1e-4);
+	}
+	RF_CHECK(snap.vehicle[CARS].driverName[0] == 0);
+
+	// opponents move on at the telemetry rate once a reader asks for it
+	TelemInfoV2 telem;
+	memset(&telem, 0, sizeof(telem));
+	telem.mDeltaTime = 1.0f / 90.0f;
+	for (int i = 0; i < 5; i++) {
+		usleep(10000);
+		rfSharedSubscribe(map, readerVehicleInterpolation);
+		plugin.UpdateTelemetry(telem);
+	}
+	RF_CHECK(rfSharedSnapshot(map, &snap));
+	RF_CHECK(snap.deltaTime > 0.0f && snap.deltaTime < RF_SHARED_MEMORY_MAX_INTERPOLATION);
+	RF_CHECK_NEAR(snap.currentET, 10.0 + snap.deltaTime, 1e-4);
+	for (int i = 0; i < CARS; i++) {
+		float moved = snap.vehicle[i].lapDist - info->mVehicle[i].mLapDist;
+		if (moved < -2000.0f) {
+			moved += info->mLapDist;
+		}
+		RF_CHECK_NEAR(moved, 50.0 * snap.deltaTime, 0.5);
+	}
+
+	// and every telemetry update went into the history ring, oldest first
+	rfMapping historyMap;
+	rfMapName(tag, sizeof(tag), RF_SHARED_MEMORY_HISTORY_NAME);
+	const rfHistory *history = (const rfHistory*)rfMapCreate(historyMap, tag, sizeof(rfHistory));
+	RF_CHECK(history != NULL);
+	if (history) {
+		rfTelemetryFrame frames[8];
+		uint32_t cursor = 0;
+		RF_CHECK(rfHistoryRead(history, cursor, frames, 8) == 5);
+		for (int i = 0; i < 5; i++) {
+			RF_CHECK(frames[i].sequence == (uint32_t)i + 1);
+		}
+		RF_CHECK(cursor == 5 && rfHistoryRead(history, cursor, frames, 8) == 0);
+	}
+	rfMapClose(historyMap);
+
+	// the same scoring again changes no entry, but the raw values must be back
+	plugin.UpdateScoring(*info);
+	RF_CHECK(rfSharedSnapshot(map, &snap));
+	RF_CHECK(snap.deltaTime == 0.0f);
+	RF_CHECK(snap.changedVehicles == 0);
+	rfMapping vehiclesMap;
+	rfMapName(tag, sizeof(tag), RF_SHARED_MEMORY_VEHICLES_NAME);
+	const rfVehicleSegment *vehicles = (const rfVehicleSegment*)rfMapCreate(vehiclesMap, tag, RF_SHARED_MEMORY_VEHICLES_SIZE(CAPACITY));
+	RF_CHECK(vehicles != NULL);
+	RF_CHECK(vehicles == NULL || (vehicles->capacity == CAPACITY && vehicles->numVehicles == CAPACITY));
+	for (int i = 0; i < CARS; i++) {
+		RF_CHECK(snap.vehicle[i].lapDist == info->mVehicle[i].mLapDist);
+		RF_CHECK(snap.vehicle[i].pos.x == info->mVehicle[i].mPos.x);
+		RF_CHECK(snap.vehicle[i].pos.z == info->mVehicle[i].mPos.z);
+		if (vehicles && i < CAPACITY) {
+			RF_CHECK(vehicles->vehicle[i].lapDist == info->mVehicle[i].mLapDist);
+			RF_CHECK(vehicles->vehicle[i].pos.x == info->mVehicle[i].mPos.x);
+		}
+	}
+	rfMapClose(vehiclesMap);
+
+	rfMapClose(readerMap);
+	plugin.Shutdown();
+	return rfTestResult("rfTestPlugin");
+}
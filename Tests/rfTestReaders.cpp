@@ -0,0 +1,92 @@
+/*
+ rfTestReaders.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Registers a reader that keeps up and one that doesn't in the plugin's reader
+ table (heap maps, rfPlatformHeap.cpp) and checks the lag, worst lag and
+ overruns the plugin reports for each, and that stale slots are freed.
+*/
+
+#include "rFactorSharedMemoryMap.hpp"
+#include "rfSharedReader.hpp"
+#include "rfTest.hpp"
+#include <string.h>
+#include <vector>
+
+static SharedMemoryMapPlugin plugin;
+static TelemInfoV2 telem;
+
+static void Publish(int frames) {
+	for (int i = 0; i < frames; i++) {
+		plugin.UpdateTelemetry(telem);
+	}
+}
+
+int main() {
+	plugin.Startup();
+	plugin.StartSession();
+	plugin.EnterRealtime();
+	memset(&telem, 0, sizeof(telem));
+	telem.mDeltaTime = 1.0f / 90.0f;
+	char tag[256];
+	rfMapName(tag, sizeof(tag), RF_SHARED_MEMORY_READERS_NAME);
+	rfMapping tableMap;
+	rfReaderTable *table = (rfReaderTable*)rfMapCreate(tableMap, tag, sizeof(rfReaderTable));
+	RF_CHECK(table != NULL);
+	if (table == NULL) {
+		return rfTestResult("rfTestReaders");
+	}
+	RF_CHECK(table->numSlots == RF_SHARED_MEMORY_MAX_READERS);
+
+	rfReaderRegistration fast, slow;
+	RF_CHECK(rfReaderRegister(fast, table, "fast"));
+	RF_CHECK(rfReaderRegister(slow, table, "slow"));
+	RF_CHECK(fast.slot != slow.slot && fast.owner != slow.owner);
+	const rfReaderStatus &fastStatus = table->status[fast.slot];
+	const rfReaderStatus &slowStatus = table->status[slow.slot];
+
+	// the fast reader consumes every frame, the slow one falls past the history ring
+	for (int i = 0; i < RF_SHARED_MEMORY_HISTORY_SIZE + 10; i++) {
+		Publish(1);
+		RF_CHECK(rfReaderConsume(fast, table->head));
+	}
+	uint32_t head = table->head;
+	RF_CHECK(head == RF_SHARED_MEMORY_HISTORY_SIZE + 10);
+	// the plugin saw the fast reader one frame behind, before it consumed
+	RF_CHECK(fastStatus.owner == fast.owner && fastStatus.lag == 1 && fastStatus.maxLag == 1);
+	RF_CHECK(fastStatus.overruns == 0);
+	RF_CHECK(slowStatus.owner == slow.owner && slowStatus.lag == head && slowStatus.maxLag == head);
+	RF_CHECK(slowStatus.overruns == 1);
+
+	// catching up clears the lag but not the worst or the overrun, and falling
+	// behind again is a second overrun
+	RF_CHECK(rfReaderConsume(slow, table->head));
+	Publish(1);
+	RF_CHECK(slowStatus.lag == 1 && slowStatus.maxLag == head && slowStatus.overruns == 1);
+	Publish(RF_SHARED_MEMORY_HISTORY_SIZE + 1);
+	RF_CHECK(slowStatus.lag == RF_SHARED_MEMORY_HISTORY_SIZE + 2 && slowStatus.overruns == 2);
+
+	// a slot that changes hands starts its counters again
+	int slot = slow.slot;
+	rfReaderUnregister(slow);
+	RF_CHECK(table->slot[slot].owner == 0);
+	RF_CHECK(rfReaderRegister(slow, table, "slow again"));
+	RF_CHECK(slow.slot == slot);
+	Publish(1);
+	RF_CHECK(slowStatus.owner == slow.owner && slowStatus.lag == 1 && slowStatus.maxLag == 1 && slowStatus.overruns == 0);
+
+	// a reader that stops reporting loses its slot on the next scoring update
+	std::vector<char> buf(sizeof(ScoringInfoV2), 0);
+	ScoringInfoV2 *info = (ScoringInfoV2*)buf.data();
+	table->slot[slow.slot].heartbeat = rfClockSeconds() - RF_SHARED_MEMORY_READER_STALE - 1.0;
+	RF_CHECK(rfReaderConsume(fast, table->head));
+	plugin.UpdateScoring(*info);
+	RF_CHECK(table->slot[slot].owner == 0);
+	RF_CHECK(!rfReaderConsume(slow, table->head));
+	RF_CHECK(rfReaderConsume(fast, table->head));
+
+	rfReaderUnregister(fast);
+	rfMapClose(tableMap);
+	plugin.Shutdown();
+	return rfTestResult("rfTestReaders");
+}
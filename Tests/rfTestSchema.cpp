@@ -0,0 +1,75 @@
+/*
+ rfTestSchema.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Fills a schema the way the plugin does at Startup and resolves paths with
+ rfSchemaResolve against the offsets the compiler gives for the same members.
+*/
+
+#include "rfSchema.hpp"
+#include "rfSharedReader.hpp"
+#include "rfTest.hpp"
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+int main() {
+	std::vector<rfSchema> buf(1);
+	rfSchema &schema = buf[0];
+	memset(&schema, 0, sizeof(schema));
+	rfSchemaFill(schema);
+	RF_CHECK(schema.numStructs > 0 && schema.numStructs <= RF_SHARED_MEMORY_SCHEMA_STRUCTS);
+	RF_CHECK(schema.numFields > 0 && schema.numFields <= RF_SHARED_MEMORY_SCHEMA_FIELDS);
+
+	// the main map is described under its map name and size
+	int shared = rfSchemaFindStruct(schema, "rfShared");
+	RF_CHECK(shared >= 0);
+	if (shared < 0) {
+		return rfTestResult("rfTestSchema");
+	}
+	RF_CHECK(schema.structs[shared].size == sizeof(rfShared));
+	RF_CHECK(strcmp(schema.structs[shared].map, RF_SHARED_MEMORY_NAME) == 0);
+	RF_CHECK(rfSchemaFindStruct(schema, "rfNoSuchStruct") == -1);
+
+	// paths resolve to the compiler's offsets, through arrays and nested structs
+	const rfSchemaField *field = NULL;
+	RF_CHECK(rfSchemaResolve(schema, "rfShared", "speed", &field) == (long)offsetof(rfShared, speed));
+	RF_CHECK(field != NULL && field->type == schemaFloat && field->count == 1 && strcmp(field->unit, "m/s") == 0);
+	RF_CHECK(rfSchemaResolve(schema, "rfShared", "wheel[2].temperature[1]", &field) ==
+		(long)(offsetof(rfShared, wheel) + 2 * sizeof(rfWheel) + offsetof(rfWheel, temperature) + sizeof(float)));
+	RF_CHECK(field != NULL && field->type == schemaFloat && field->count == 3);
+	RF_CHECK(rfSchemaResolve(schema, "rfShared", "vehicle[5].pos[2]") ==
+		(long)(offsetof(rfShared, vehicle) + 5 * sizeof(rfVehicleInfo) + offsetof(rfVehicleInfo, pos) + 2 * sizeof(float)));
+	RF_CHECK(rfSchemaResolve(schema, "rfShared", "vehicle[63].driverName", &field) ==
+		(long)(offsetof(rfShared, vehicle) + 63 * sizeof(rfVehicleInfo) + offsetof(rfVehicleInfo, driverName)));
+	RF_CHECK(field != NULL && field->type == schemaChar && field->count == sizeof(((rfVehicleInfo*)0)->driverName));
+	// an unindexed array is its first element
+	RF_CHECK(rfSchemaResolve(schema, "rfShared", "wheel.wear") == (long)(offsetof(rfShared, wheel) + offsetof(rfWheel, wear)));
+	RF_CHECK(rfSchemaResolve(schema, "rfVehicleSegment", "vehicle[100].lapDist") ==
+		(long)(offsetof(rfVehicleSegment, vehicle) + 100 * sizeof(rfVehicleInfo) + offsetof(rfVehicleInfo, lapDist)));
+
+	// and anything that isn't a member doesn't
+	RF_CHECK(rfSchemaResolve(schema, "rfShared", "noSuchField") == -1);
+	RF_CHECK(rfSchemaResolve(schema, "rfShared", "spee") == -1);
+	RF_CHECK(rfSchemaResolve(schema, "rfShared", "speed.x") == -1);
+	RF_CHECK(rfSchemaResolve(schema, "rfShared", "wheel[4].wear") == -1);
+	RF_CHECK(rfSchemaResolve(schema, "rfShared", "wheel[].wear") == -1);
+	RF_CHECK(rfSchemaResolve(schema, "rfShared", "wheel[1") == -1);
+	RF_CHECK(rfSchemaResolve(schema, "rfShared", "wheel[1].") == -1);
+	RF_CHECK(rfSchemaResolve(schema, "rfShared", "reserved0") == -1);
+	RF_CHECK(rfSchemaResolve(schema, "rfNoSuchStruct", "speed") == -1);
+
+	// every described field lies inside its struct, in declaration order, and resolves by name
+	for (uint32_t s = 0; s < schema.numStructs; s++) {
+		const rfSchemaStruct &st = schema.structs[s];
+		RF_CHECK(st.numFields > 0 && (uint32_t)st.firstField + st.numFields <= schema.numFields);
+		for (uint32_t i = st.firstField; i < (uint32_t)st.firstField + st.numFields; i++) {
+			const rfSchemaField &f = schema.field[i];
+			RF_CHECK(f.offset + f.size * f.count <= st.size);
+			RF_CHECK(i == st.firstField || f.offset >= schema.field[i - 1].offset + schema.field[i - 1].size * schema.field[i - 1].count);
+			RF_CHECK(f.type != schemaStruct || (f.ref < schema.numStructs && schema.structs[f.ref].size == f.size));
+			RF_CHECK(rfSchemaResolve(schema, st.name, f.name) == (long)f.offset);
+		}
+	}
+	return rfTestResult("rfTestSchema");
+}
@@ -0,0 +1,85 @@
+/*
+ rfTestSignal.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Blocks readers in rfSignalWait (rfPlatformPosix.cpp) and checks they time
+ out, wake on rfSignalNotify, and always take their waiter count back.
+*/
+
+#include "rfPlatform.hpp"
+#include "rfTest.hpp"
+#include <atomic>
+#include <thread>
+#include <unistd.h>
+
+#define READERS 4
+
+static volatile uint32_t counter = 0;
+static volatile uint32_t waiters = 0;
+static rfSignal wakeup;
+
+static std::atomic<int> woken(0);
+
+static void Reader(uint32_t last) {
+	if (rfSignalWait(wakeup, last, -1.0)) {
+		woken++;
+	}
+}
+
+// wait up to a second for n readers to be blocked
+static bool WaitForWaiters(uint32_t n) {
+	for (int i = 0; i < 1000 && waiters != n; i++) {
+		usleep(1000);
+	}
+	return waiters == n;
+}
+
+int main() {
+	RF_CHECK(rfSignalOpen(wakeup, "rfTestSignal", &counter, &waiters));
+
+	// nothing published: the wait runs out and says so
+	double start = rfClockSeconds();
+	RF_CHECK(!rfSignalWait(wakeup, counter, 0.05));
+	double waited = rfClockSeconds() - start;
+	RF_CHECK(waited >= 0.04 && waited < 1.0);
+	RF_CHECK(waiters == 0);
+
+	// already published since last: back at once
+	uint32_t last = counter;
+	rfSignalNotify(wakeup);
+	start = rfClockSeconds();
+	RF_CHECK(rfSignalWait(wakeup, last, 1.0));
+	RF_CHECK(rfClockSeconds() - start < 0.5);
+	RF_CHECK(waiters == 0);
+
+	// one publication wakes every blocked reader
+	last = counter;
+	std::thread readers[READERS];
+	for (int i = 0; i < READERS; i++) {
+		readers[i] = std::thread(Reader, last);
+	}
+	RF_CHECK(WaitForWaiters(READERS));
+	RF_CHECK(woken == 0);
+	rfSignalNotify(wakeup);
+	for (int i = 0; i < READERS; i++) {
+		readers[i].join();
+	}
+	RF_CHECK(woken == READERS);
+	RF_CHECK(waiters == 0);
+	RF_CHECK(counter == last + 1);
+
+	// and a timed out reader leaves nothing behind for the next one
+	last = counter;
+	RF_CHECK(!rfSignalWait(wakeup, last, 0.01));
+	RF_CHECK(waiters == 0);
+	woken = 0;
+	std::thread reader(Reader, last);
+	RF_CHECK(WaitForWaiters(1));
+	RF_CHECK(woken == 0);
+	rfSignalNotify(wakeup);
+	reader.join();
+	RF_CHECK(woken == 1 && waiters == 0);
+
+	rfSignalClose(wakeup);
+	return rfTestResult("rfTestSignal");
+}
@@ -0,0 +1,138 @@
+/*
+ rfTestStandings.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Builds standings for 2000 random fields, with tied places, unplaced cars and
+ up to five classes, and checks them against a stable sort of the same field.
+*/
+
+#include "rfStandings.hpp"
+#include "rfTest.hpp"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define FIELDS 2000
+
+static const char *classes[] = { "GT1", "GT2", "LMP1", "LMP2", "Formula" };
+
+static uint32_t seed = 12345;
+
+// small LCG so every run draws the same fields
+static uint32_t Random(uint32_t range) {
+	seed = seed * 1664525u + 1013904223u;
+	return (seed >> 8) % range;
+}
+
+static unsigned Key(const rfVehicleInfo &v) {
+	return v.place ? v.place : 256;
+}
+
+static void Check(const std::vector<rfVehicleInfo> &vehicle, int n, const rfStandings &standings) {
+	RF_CHECK(standings.numVehicles == n);
+
+	// overall is the field stably sorted by place, unplaced cars last
+	std::vector<int> order(n);
+	for (int i = 0; i < n; i++) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&vehicle](int a, int b) { return Key(vehicle[a]) < Key(vehicle[b]); });
+	bool same = true;
+	for (int p = 0; p < n; p++) {
+		same = same && standings.overall[p] == order[p];
+	}
+	RF_CHECK(same);
+
+	// classes are numbered in the order their leaders come up overall
+	std::vector<std::string> seen;
+	for (int p = 0; p < n; p++) {
+		std::string name = vehicle[order[p]].vehicleClass;
+		if (std::find(seen.begin(), seen.end(), name) == seen.end()) {
+			seen.push_back(name);
+		}
+	}
+	RF_CHECK(standings.numClasses == (int)seen.size());
+
+	// and byClass walks each class in overall order
+	int start = 0;
+	for (int c = 0; c < (int)seen.size() && c < standings.numClasses; c++) {
+		RF_CHECK(standings.classStart[c] == start);
+		int place = 0;
+		for (int p = 0; p < n; p++) {
+			int v = order[p];
+			if (seen[c] != vehicle[v].vehicleClass) {
+				continue;
+			}
+			RF_CHECK(standings.byClass[start + place] == v);
+			RF_CHECK(standings.vehicleClassId[v] == c);
+			RF_CHECK(standings.classPlace[v] == ++place);
+		}
+		RF_CHECK(standings.classCount[c] == place);
+		start += place;
+	}
+	RF_CHECK(start == n);
+}
+
+int main() {
+	rfStandingsBuilder builder;
+	std::vector<rfStandings> buf(1);
+	rfStandings &standings = buf[0];
+	memset(&standings, 0, sizeof(standings));
+	std::vector<rfVehicleInfo> vehicle(RF_SHARED_MEMORY_MAX_VEHICLES);
+	int ties = 0, unplaced = 0;
+	for (int field = 0; field < FIELDS; field++) {
+		int n = (int)Random(RF_SHARED_MEMORY_MAX_VEHICLES + 1);
+		int numClasses = 1 + (int)Random(5);
+		memset(vehicle.data(), 0, vehicle.size() * sizeof(rfVehicleInfo));
+		// mostly a permutation of places, with some cars sharing one or without one
+		std::vector<int> places(n);
+		for (int i = 0; i < n; i++) {
+			places[i] = i + 1;
+		}
+		for (int i = n - 1; i > 0; i--) {
+			std::swap(places[i], places[Random(i + 1)]);
+		}
+		for (int i = 0; i < n; i++) {
+			uint32_t r = Random(20);
+			if (r == 0) {
+				places[i] = 0;
+				unplaced++;
+			} else if (r == 1 && n > 1) {
+				places[i] = places[Random(n)];
+				ties++;
+			}
+			vehicle[i].place = (unsigned char)places[i];
+			strcpy(vehicle[i].vehicleClass, classes[Random(numClasses)]);
+		}
+		// two empty fields in a row are the same field, and not rebuilt
+		RF_CHECK(builder.Update(vehicle.data(), n, standings) || n == 0);
+		Check(vehicle, n, standings);
+
+		// the same field again isn't rebuilt
+		uint32_t generation = standings.generation;
+		RF_CHECK(!builder.Update(vehicle.data(), n, standings));
+		RF_CHECK(standings.generation == generation);
+	}
+	printf("%d fields, %d tied places, %d unplaced cars\n", FIELDS, ties, unplaced);
+
+	// one car changing class is enough to rebuild
+	int n = 10;
+	for (int i = 0; i < n; i++) {
+		vehicle[i].place = (unsigned char)(i + 1);
+		strcpy(vehicle[i].vehicleClass, "GT1");
+	}
+	builder.Update(vehicle.data(), n, standings);
+	strcpy(vehicle[4].vehicleClass, "GT2");
+	uint32_t generation = standings.generation;
+	RF_CHECK(builder.Update(vehicle.data(), n, standings));
+	RF_CHECK(standings.generation == generation + 1);
+	Check(vehicle, n, standings);
+	RF_CHECK(standings.numClasses == 2 && standings.classPlace[4] == 1 && standings.classPlace[5] == 5);
+
+	// and so is a car leaving
+	RF_CHECK(builder.Update(vehicle.data(), n - 1, standings));
+	Check(vehicle, n - 1, standings);
+	return rfTestResult("rfTestStandings");
+}
@@ -0,0 +1,130 @@
+/*
+ rfTestStrings.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Checks the ids the plugin publishes next to track, driver, class and
+ terrain names resolve to the same text through the string table (heap maps,
+ rfPlatformHeap.cpp), then fills an interner's table to the brim.
+*/
+
+#include "rFactorSharedMemoryMap.hpp"
+#include "rfSharedReader.hpp"
+#include "rfTest.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define CARS 12
+
+static void MakeScoring(std::vector<char> &buf, ScoringInfoV2 *&info) {
+	buf.assign(sizeof(ScoringInfoV2) + CARS * sizeof(VehicleScoringInfoV2), 0);
+	info = (ScoringInfoV2*)buf.data();
+	VehicleScoringInfoV2 *veh = (VehicleScoringInfoV2*)(buf.data() + sizeof(ScoringInfoV2));
+	strcpy(info->mTrackName, "Synthetic Oval");
+	info->mLapDist = 4000.0f;
+	info->mNumVehicles = CARS;
+	info->mVehicle = veh;
+	for (int i = 0; i < CARS; i++) {
+		sprintf(veh[i].mDriverName, "Driver %d", i + 1);
+		// three classes shared across the field
+		strcpy(veh[i].mVehicleClass, i % 3 == 0 ? "GT1" : i % 3 == 1 ? "GT2" : "LMP");
+		veh[i].mPlace = (unsigned char)(i + 1);
+	}
+}
+
+// the id resolves to text, which is the same as the inline copy
+static bool Resolves(const rfStringTable *table, uint16_t id, const char *text) {
+	if (text[0] == 0) {
+		return id == 0;
+	}
+	const char *s = rfStringLookup(table, id);
+	return id != 0 && s != NULL && strcmp(s, text) == 0;
+}
+
+int main() {
+	SharedMemoryMapPlugin plugin;
+	plugin.Startup();
+	plugin.StartSession();
+	plugin.EnterRealtime();
+	char tag[256];
+	rfMapping readerMap, stringsMap;
+	rfMapName(tag, sizeof(tag), RF_SHARED_MEMORY_NAME);
+	rfShared *map = (rfShared*)rfMapCreate(readerMap, tag, sizeof(rfShared));
+	rfMapName(tag, sizeof(tag), RF_SHARED_MEMORY_STRINGS_NAME);
+	const rfStringTable *table = (const rfStringTable*)rfMapCreate(stringsMap, tag, sizeof(rfStringTable));
+	RF_CHECK(map != NULL && table != NULL);
+	if (map == NULL || table == NULL) {
+		return rfTestResult("rfTestStrings");
+	}
+	std::vector<rfShared> copy(1);
+	rfShared &snap = copy[0];
+
+	std::vector<char> buf;
+	ScoringInfoV2 *info;
+	MakeScoring(buf, info);
+	plugin.UpdateScoring(*info);
+	TelemInfoV2 telem;
+	memset(&telem, 0, sizeof(telem));
+	strcpy(telem.mTrackName, "Synthetic Oval");
+	strcpy(telem.mWheel[0].mTerrainName, "ROAD");
+	strcpy(telem.mWheel[1].mTerrainName, "ROAD");
+	strcpy(telem.mWheel[2].mTerrainName, "GRASS");
+	plugin.UpdateTelemetry(telem);
+
+	// every published name resolves, and the same name always has the same id
+	RF_CHECK(rfSharedSnapshot(map, &snap));
+	RF_CHECK(Resolves(table, snap.trackNameId, snap.trackName));
+	RF_CHECK(strcmp(snap.trackName, "Synthetic Oval") == 0);
+	for (int w = 0; w < 4; w++) {
+		RF_CHECK(Resolves(table, snap.wheel[w].terrainNameId, snap.wheel[w].terrainName));
+	}
+	RF_CHECK(snap.wheel[0].terrainNameId == snap.wheel[1].terrainNameId);
+	RF_CHECK(snap.wheel[0].terrainNameId != snap.wheel[2].terrainNameId && snap.wheel[3].terrainNameId == 0);
+	for (int i = 0; i < CARS; i++) {
+		RF_CHECK(Resolves(table, snap.vehicle[i].driverNameId, snap.vehicle[i].driverName));
+		RF_CHECK(Resolves(table, snap.vehicle[i].vehicleClassNameId, snap.vehicle[i].vehicleClass));
+		RF_CHECK(snap.vehicle[i].vehicleClassNameId == snap.vehicle[i % 3].vehicleClassNameId);
+		for (int j = 0; j < i; j++) {
+			RF_CHECK(snap.vehicle[i].driverNameId != snap.vehicle[j].driverNameId);
+		}
+	}
+	// the track, 12 drivers, 3 classes and 2 terrains, after the empty string
+	RF_CHECK(table->numStrings == 1 + 1 + CARS + 3 + 2);
+
+	// a driver swap gets a new id, and the old one still resolves
+	uint16_t oldId = snap.vehicle[5].driverNameId;
+	strcpy(info->mVehicle[5].mDriverName, "Relief Driver");
+	plugin.UpdateScoring(*info);
+	RF_CHECK(rfSharedSnapshot(map, &snap));
+	RF_CHECK(snap.vehicle[5].driverNameId != oldId);
+	RF_CHECK(Resolves(table, snap.vehicle[5].driverNameId, "Relief Driver"));
+	RF_CHECK(Resolves(table, oldId, "Driver 6"));
+	RF_CHECK(rfStringLookup(table, table->numStrings) == NULL);
+	rfMapClose(stringsMap);
+	rfMapClose(readerMap);
+	plugin.Shutdown();
+
+	// a table of its own: long names are cut to fit, and a full table hands out 0
+	std::vector<rfStringTable> own(1);
+	rfStringInterner interner;
+	interner.Reset(own[0]);
+	char name[128];
+	memset(name, 'x', sizeof(name) - 1);
+	name[sizeof(name) - 1] = 0;
+	uint16_t longId = interner.Add(own[0], name);
+	RF_CHECK(longId == 1 && strlen(own[0].text[longId]) == RF_SHARED_MEMORY_STRING_SIZE - 1);
+	RF_CHECK(interner.Find(own[0], name) == longId);
+	for (int i = 2; i < RF_SHARED_MEMORY_MAX_STRINGS; i++) {
+		sprintf(name, "name %d", i);
+		RF_CHECK(interner.Add(own[0], name) == i);
+	}
+	RF_CHECK(interner.Add(own[0], "one too many") == 0);
+	bool found = true;
+	for (int i = 2; i < RF_SHARED_MEMORY_MAX_STRINGS; i++) {
+		sprintf(name, "name %d", i);
+		found = found && interner.Find(own[0], name) == i && strcmp(rfStringLookup(&own[0], i), name) == 0;
+	}
+	RF_CHECK(found);
+	RF_CHECK(interner.Find(own[0], "one too many") == 0);
+	return rfTestResult("rfTestStrings");
+}
@@ -0,0 +1,161 @@
+/*
+ rfTestTrack.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Lays a track line into an rfTrackSegment the way the plugin spaces its knots
+ and projects points back onto it with rfTrackDistance: an oval, then a
+ serpentine whose legs run close enough side by side that the nearest coarse
+ knots can all be on the wrong leg, and a figure-8 that crosses itself.
+*/
+
+#include "rfSharedReader.hpp"
+#include "rfTest.hpp"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define PI 3.14159265358979
+
+struct Point {
+	double x, z;
+};
+
+static std::vector<rfTrackSegment> trackBuf(1);
+static rfTrackSegment &track = trackBuf[0];
+static std::vector<Point> path;
+
+// the path is built from straights and arcs sampled every 10 cm
+static void Straight(double x, double z) {
+	Point a = path.back();
+	double length = hypot(x - a.x, z - a.z);
+	int steps = (int)ceil(length / 0.1);
+	for (int i = 1; i <= steps; i++) {
+		Point p = { a.x + (x - a.x) * i / steps, a.z + (z - a.z) * i / steps };
+		path.push_back(p);
+	}
+}
+
+static void Arc(double cx, double cz, double radius, double from, double to) {
+	int steps = (int)ceil(fabs(to - from) * radius / 0.1);
+	for (int i = 1; i <= steps; i++) {
+		double angle = from + (to - from) * i / steps;
+		Point p = { cx + radius * cos(angle), cz + radius * sin(angle) };
+		path.push_back(p);
+	}
+}
+
+// position and direction at lapDist d along the path
+static Point At(double d, Point *dir = NULL) {
+	double walked = 0.0;
+	for (size_t i = 1; i < path.size(); i++) {
+		double step = hypot(path[i].x - path[i - 1].x, path[i].z - path[i - 1].z);
+		if (walked + step >= d || i + 1 == path.size()) {
+			double f = step > 0.0 ? (d - walked) / step : 0.0;
+			if (dir) {
+				dir->x = (path[i].x - path[i - 1].x) / step;
+				dir->z = (path[i].z - path[i - 1].z) / step;
+			}
+			Point p = { path[i - 1].x + (path[i].x - path[i - 1].x) * f, path[i - 1].z + (path[i].z - path[i - 1].z) * f };
+			return p;
+		}
+		walked += step;
+	}
+	return path.back();
+}
+
+// knots every RF_SHARED_MEMORY_KNOT_SPACING along the closed path, as the learner spaces them
+static float Learn() {
+	double length = 0.0;
+	for (size_t i = 1; i < path.size(); i++) {
+		length += hypot(path[i].x - path[i - 1].x, path[i].z - path[i - 1].z);
+	}
+	memset(&track, 0, sizeof(track));
+	track.numKnots = (uint32_t)ceil(length / RF_SHARED_MEMORY_KNOT_SPACING);
+	track.length = (float)length;
+	track.spacing = (float)(length / track.numKnots);
+	for (uint32_t k = 0; k < track.numKnots; k++) {
+		Point p = At(k * length / track.numKnots);
+		track.knot[k].pos.x = (float)p.x;
+		track.knot[k].pos.z = (float)p.z;
+		track.knot[k].weight = 1.0f;
+	}
+	track.learned = track.numKnots;
+	return track.length;
+}
+
+// lapDist error wrapped around the lap
+static double LapError(double found, double d) {
+	double e = fabs(found - d);
+	return e < track.length - e ? e : track.length - e;
+}
+
+// worst error projecting points every metre of the lap, lateral metres off the
+// line, skipping those within skip metres of the origin
+static double WorstError(double lateral, bool hint, double skip = 0.0) {
+	double worst = 0.0;
+	for (double d = 0.0; d < track.length; d += 1.0) {
+		Point dir;
+		Point p = At(d, &dir);
+		if (hypot(p.x, p.z) < skip) {
+			continue;
+		}
+		rfVec3 pos = { (float)(p.x - dir.z * lateral), 0.0f, (float)(p.z + dir.x * lateral) };
+		float found = rfTrackDistance(track, pos, hint ? (float)fmod(d + track.length - 3.0, track.length) : -1.0f);
+		worst = fmax(worst, LapError(found, d));
+	}
+	return worst;
+}
+
+int main() {
+	// nothing learned, nothing found
+	memset(&track, 0, sizeof(track));
+	rfVec3 origin = { 0.0f, 0.0f, 0.0f };
+	RF_CHECK(rfTrackDistance(track, origin) == -1.0f);
+
+	// an oval: two 1 km straights joined by 150 m radius turns
+	path.assign(1, Point{ 0.0, 0.0 });
+	Straight(1000.0, 0.0);
+	Arc(1000.0, 150.0, 150.0, -PI / 2, PI / 2);
+	Straight(0.0, 300.0);
+	Arc(0.0, 150.0, 150.0, PI / 2, 3 * PI / 2);
+	Learn();
+	RF_CHECK(WorstError(0.0, false) < 0.5);
+	RF_CHECK(WorstError(5.0, false) < 1.0);
+	RF_CHECK(WorstError(5.0, true) < 1.0);
+
+	// a serpentine: four 300 m legs 14 m apart joined by hairpins, then back along the outside
+	path.assign(1, Point{ 0.0, 0.0 });
+	for (int leg = 0; leg < 4; leg++) {
+		double z = leg * 14.0;
+		bool out = leg % 2 == 0;
+		Straight(out ? 300.0 : 0.0, z);
+		if (leg < 3) {
+			Arc(out ? 300.0 : 0.0, z + 7.0, 7.0, out ? -PI / 2 : 3 * PI / 2, PI / 2);
+		}
+	}
+	Straight(-60.0, 42.0);
+	Arc(-60.0, 21.0, 21.0, PI / 2, 3 * PI / 2);
+	Straight(0.0, 0.0);
+	Learn();
+	double worst = WorstError(0.0, false);
+	printf("serpentine worst error %.2f m on the line, %.2f m 4 m off it\n", worst, WorstError(4.0, false));
+	RF_CHECK(worst < 0.5);
+	// off the line round a 7 m hairpin the knots are too coarse for better than a couple of metres
+	RF_CHECK(WorstError(4.0, false) < 2.0);
+	RF_CHECK(WorstError(4.0, true) < 2.0);
+
+	// a figure-8 crossing itself square at the origin, where both legs are equally close
+	path.assign(1, Point{ 0.0, 0.0 });
+	for (int i = 1; i <= 20000; i++) {
+		double t = 2 * PI * i / 20000;
+		Point p = { 300.0 * sin(t), 150.0 * sin(2 * t) };
+		path.push_back(p);
+	}
+	Learn();
+	worst = WorstError(0.0, false, 2.0);
+	printf("figure-8 worst error %.2f m on the line, %.2f m 4 m off it\n", worst, WorstError(4.0, false, 8.0));
+	RF_CHECK(worst < 0.5);
+	RF_CHECK(WorstError(4.0, false, 8.0) < 1.0);
+	return rfTestResult("rfTestTrack");
+}
@@ -0,0 +1,274 @@
+/*
+ rfBench.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Microbenchmarks for the plugin's hot paths, linked against rfPlatformHeap.cpp
+ so every map is a plain heap block:
+
+   UpdateTelemetry    with 1, 16, 32 and 64 vehicles being interpolated
+   UpdateScoring      for the same field sizes
+   StartSession       clearing the buffers between sessions
+   UpdateGraphics     publishing the camera, once per rendered frame
+
+ For each one it reports ns/call and the number of mapped bytes a single call
+ writes. Bytes written are found by filling every map with a poison pattern,
+ making one call and counting the bytes that changed.
+
+ usage: rfBench [-seconds S]   (time spent on each benchmark, default 0.5)
+*/
+
+#include "rFactorSharedMemoryMap.hpp"
+#include "rfPlatformHeap.hpp"
+#include "rfSharedReader.hpp"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+typedef std::chrono::steady_clock benchClock;
+
+#define POISON 0xA5
+
+static const int fieldSizes[] = { 1, 16, 32, 64 };
+
+struct benchScoring {
+	std::vector<char> buf;
+	ScoringInfoV2 *info;
+};
+
+// cars spread around a 4 km circle, as in rfReplay's synthetic session
+static void MakeScoring(benchScoring &s, int cars, float et) {
+	const float trackLength = 4000.0f;
+	const float radius = trackLength / (2.0f * 3.14159265f);
+	s.buf.assign(sizeof(ScoringInfoV2) + cars * sizeof(VehicleScoringInfoV2), 0);
+	s.info = (ScoringInfoV2*)s.buf.data();
+	VehicleScoringInfoV2 *veh = (VehicleScoringInfoV2*)(s.buf.data() + sizeof(ScoringInfoV2));
+	strcpy(s.info->mTrackName, "Synthetic Oval");
+	strcpy(s.info->mPlayerName, "Player");
+	strcpy(s.info->mPlrFileName, "Player");
+	s.info->mSession = 10;
+	s.info->mCurrentET = et;
+	s.info->mLapDist = trackLength;
+	s.info->mNumVehicles = cars;
+	s.info->mGamePhase = 5;
+	s.info->mVehicle = veh;
+	for (int i = 0; i < cars; i++) {
+		float speed = 50.0f + i * 0.1f;
+		float dist = trackLength - i * (trackLength / cars);
+		float angle = dist / radius;
+		VehicleScoringInfoV2 &v = veh[i];
+		sprintf(v.mDriverName, "Driver %d", i + 1);
+		strcpy(v.mVehicleClass, i % 2 ? "GT2" : "GT1");
+		v.mIsPlayer = (i == 0);
+		v.mControl = (i == 0) ? 0 : 1;
+		v.mPlace = (unsigned char)(i + 1);
+		v.mLapDist = dist;
+		v.mPos.Set(radius * sinf(angle), 0.0f, radius * cosf(angle));
+		v.mOriX.Set(cosf(angle), 0.0f, -sinf(angle));
+		v.mOriY.Set(0.0f, 1.0f, 0.0f);
+		v.mOriZ.Set(sinf(angle), 0.0f, cosf(angle));
+		v.mLocalVel.Set(0.0f, 0.0f, -speed);
+		v.mLocalAccel.Set(speed * speed / radius, 0.0f, 0.0f);
+		v.mLocalRot.Set(0.0f, speed / radius, 0.0f);
+	}
+}
+
+static void MakeTelemetry(TelemInfoV2 &telem) {
+	memset(&telem, 0, sizeof(telem));
+	strcpy(telem.mTrackName, "Synthetic Oval");
+	strcpy(telem.mVehicleName, "Synthetic Car");
+	for (int w = 0; w < 4; w++) {
+		strcpy(telem.mWheel[w].mTerrainName, "ROAD");
+	}
+	telem.mDeltaTime = 1.0f / 90.0f;
+	telem.mGear = 4;
+	telem.mEngineRPM = 7000.0f;
+	telem.mUnfilteredThrottle = 1.0f;
+}
+
+// poison every map, so bytes changed by the next call can be counted
+static void PoisonMaps() {
+	for (int i = 0; i < rfHeapMapCount(); i++) {
+		size_t size;
+		void *view = rfHeapMapView(i, size);
+		memset(view, POISON, size);
+	}
+}
+
+static size_t CountWritten() {
+	size_t written = 0;
+	for (int i = 0; i < rfHeapMapCount(); i++) {
+		size_t size;
+		const unsigned char *view = (const unsigned char*)rfHeapMapView(i, size);
+		for (size_t j = 0; j < size; j++) {
+			written += (view[j] != POISON);
+		}
+	}
+	return written;
+}
+
+static void Report(const char *name, int cars, double ns, size_t bytes) {
+	char label[64];
+	if (cars > 0) {
+		snprintf(label, sizeof(label), "%s/%d", name, cars);
+	} else {
+		snprintf(label, sizeof(label), "%s", name);
+	}
+	printf("%-20s %10.1f %14u\n", label, ns, (unsigned)bytes);
+}
+
+// start a fresh plugin with a reader attached to the main map
+static void Begin(SharedMemoryMapPlugin &plugin, rfMapping &readerMap, rfShared *&reader) {
+	plugin.Startup();
+	plugin.StartSession();
+	plugin.EnterRealtime();
+	char tag[256];
+	rfMapName(tag, sizeof(tag), RF_SHARED_MEMORY_NAME);
+	reader = (rfShared*)rfMapCreate(readerMap, tag, sizeof(rfShared));
+}
+
+static void End(SharedMemoryMapPlugin &plugin, rfMapping &readerMap) {
+	rfMapClose(readerMap);
+	plugin.Shutdown();
+}
+
+static void BenchTelemetry(int cars, double seconds) {
+	SharedMemoryMapPlugin plugin;
+	rfMapping readerMap;
+	rfShared *reader;
+	Begin(plugin, readerMap, reader);
+	benchScoring scoring;
+	MakeScoring(scoring, cars, 10.0f);
+	TelemInfoV2 telem;
+	MakeTelemetry(telem);
+
+	// keep every call inside the interpolation window by re-scoring (untimed)
+	// well before RF_SHARED_MEMORY_MAX_INTERPOLATION runs out
+	const int batch = 256;
+	long long calls = 0;
+	double timed = 0.0;
+	benchClock::time_point scored = benchClock::time_point();
+	while (timed < seconds) {
+		if (std::chrono::duration<double>(benchClock::now() - scored).count() > 0.25) {
+			plugin.UpdateScoring(*scoring.info);
+			scored = benchClock::now();
+		}
+		benchClock::time_point before = benchClock::now();
+		for (int i = 0; i < batch; i++) {
+			rfSharedSubscribe(reader, readerVehicleInterpolation);
+			plugin.UpdateTelemetry(telem);
+		}
+		timed += std::chrono::duration<double>(benchClock::now() - before).count();
+		calls += batch;
+	}
+
+	plugin.UpdateScoring(*scoring.info);
+	PoisonMaps();
+	// the reader flags were poisoned to all ones, so interpolation still runs
+	plugin.UpdateTelemetry(telem);
+	Report("UpdateTelemetry", cars, timed * 1e9 / calls, CountWritten());
+	End(plugin, readerMap);
+}
+
+static void BenchScoring(int cars, double seconds) {
+	SharedMemoryMapPlugin plugin;
+	rfMapping readerMap;
+	rfShared *reader;
+	Begin(plugin, readerMap, reader);
+	benchScoring scoring;
+	MakeScoring(scoring, cars, 10.0f);
+
+	const int batch = 64;
+	long long calls = 0;
+	double timed = 0.0;
+	while (timed < seconds) {
+		benchClock::time_point before = benchClock::now();
+		for (int i = 0; i < batch; i++) {
+			plugin.UpdateScoring(*scoring.info);
+		}
+		timed += std::chrono::duration<double>(benchClock::now() - before).count();
+		calls += batch;
+	}
+
+	PoisonMaps();
+	plugin.UpdateScoring(*scoring.info);
+	Report("UpdateScoring", cars, timed * 1e9 / calls, CountWritten());
+	End(plugin, readerMap);
+}
+
+static void BenchStartSession(double seconds) {
+	SharedMemoryMapPlugin plugin;
+	rfMapping readerMap;
+	rfShared *reader;
+	Begin(plugin, readerMap, reader);
+
+	const int batch = 64;
+	long long calls = 0;
+	double timed = 0.0;
+	while (timed < seconds) {
+		benchClock::time_point before = benchClock::now();
+		for (int i = 0; i < batch; i++) {
+			plugin.StartSession();
+		}
+		timed += std::chrono::duration<double>(benchClock::now() - before).count();
+		calls += batch;
+	}
+
+	PoisonMaps();
+	plugin.StartSession();
+	Report("StartSession", 0, timed * 1e9 / calls, CountWritten());
+	End(plugin, readerMap);
+}
+
+static void BenchGraphics(double seconds) {
+	SharedMemoryMapPlugin plugin;
+	rfMapping readerMap;
+	rfShared *reader;
+	Begin(plugin, readerMap, reader);
+	GraphicsInfoV2 info;
+	memset(&info, 0, sizeof(info));
+	info.mCamPos.Set(100.0f, 2.0f, -50.0f);
+	info.mAmbientRed = info.mAmbientGreen = info.mAmbientBlue = 1.0f;
+
+	const int batch = 256;
+	long long calls = 0;
+	double timed = 0.0;
+	while (timed < seconds) {
+		benchClock::time_point before = benchClock::now();
+		for (int i = 0; i < batch; i++) {
+			plugin.UpdateGraphics(info);
+		}
+		timed += std::chrono::duration<double>(benchClock::now() - before).count();
+		calls += batch;
+	}
+
+	PoisonMaps();
+	plugin.UpdateGraphics(info);
+	Report("UpdateGraphics", 0, timed * 1e9 / calls, CountWritten());
+	End(plugin, readerMap);
+}
+
+int main(int argc, char **argv) {
+	double seconds = 0.5;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-seconds") == 0 && i + 1 < argc) {
+			seconds = atof(argv[++i]);
+		} else {
+			fprintf(stderr, "usage: %s [-seconds S]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	printf("%-20s %10s %14s\n", "benchmark", "ns/call", "bytes written");
+	for (size_t i = 0; i < sizeof(fieldSizes) / sizeof(fieldSizes[0]); i++) {
+		BenchTelemetry(fieldSizes[i], seconds);
+	}
+	for (size_t i = 0; i < sizeof(fieldSizes) / sizeof(fieldSizes[0]); i++) {
+		BenchScoring(fieldSizes[i], seconds);
+	}
+	BenchStartSession(seconds);
+	BenchGraphics(seconds);
+	return 0;
+}
@@ -0,0 +1,108 @@
+/*
+ rfConvert.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Converts a plain capture (rfCapture.hpp) into a seekable archive
+ (rfArchive.hpp), or lists the keyframe index of an archive.
+
+ usage: rfConvert [-keyframe S] capture.rfcap archive.rfarc
+        rfConvert -list archive.rfarc
+*/
+
+#include "rfArchive.hpp"
+#include "rfPlatform.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static int Convert(const char *in, const char *out, double keyframe) {
+	FILE *f = fopen(in, "rb");
+	if (f == NULL) {
+		fprintf(stderr, "unable to open %s\n", in);
+		return 1;
+	}
+	rfCaptureHeader header;
+	if (fread(&header, sizeof(header), 1, f) != 1 || !rfCaptureCompatible(header)) {
+		fprintf(stderr, "%s is not a capture this build can convert\n", in);
+		fclose(f);
+		return 1;
+	}
+	rfArchiveWriter writer;
+	if (!writer.Open(out, header, keyframe)) {
+		fprintf(stderr, "unable to create %s\n", out);
+		fclose(f);
+		return 1;
+	}
+	rfCaptureRecord record;
+	std::vector<char> payload;
+	unsigned long long records = 0, bytes = sizeof(header);
+	while (fread(&record, sizeof(record), 1, f) == 1) {
+		payload.resize(record.size);
+		if (record.size > 0 && fread(payload.data(), record.size, 1, f) != 1) {
+			fprintf(stderr, "%s is truncated\n", in);
+			break;
+		}
+		writer.Write(record, payload.data());
+		records++;
+		bytes += sizeof(record) + record.size;
+	}
+	fclose(f);
+	size_t keyframes = writer.Keyframes();
+	if (!writer.Close()) {
+		fprintf(stderr, "error writing %s\n", out);
+		return 1;
+	}
+	unsigned long long written = 0;
+	FILE *o = fopen(out, "rb");
+	if (o != NULL) {
+		fseek(o, 0, SEEK_END);
+		written = rfTell(o);
+		fclose(o);
+	}
+	printf("%llu records, %u keyframes, %llu bytes -> %llu bytes (%.1f%%)\n", records, (unsigned)keyframes,
+		bytes, written, bytes ? 100.0 * written / bytes : 0.0);
+	return 0;
+}
+
+static int List(const char *path) {
+	rfArchiveReader reader;
+	if (!reader.Open(path)) {
+		fprintf(stderr, "%s is not an archive this build can read\n", path);
+		return 1;
+	}
+	printf("%8s %10s %10s %8s %6s %6s %14s\n", "keyframe", "time", "currentET", "session", "lap", "sector", "offset");
+	const std::vector<rfArchiveIndexEntry> &index = reader.Index();
+	for (size_t i = 0; i < index.size(); i++) {
+		const rfArchiveIndexEntry &e = index[i];
+		printf("%8u %10.3f %10.3f %8u %6d %6d %14llu\n", (unsigned)i, e.time, e.currentET, e.session, e.lap, e.sector, e.offset);
+	}
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	double keyframe = RF_ARCHIVE_KEYFRAME_INTERVAL;
+	const char *list = NULL;
+	const char *paths[2] = { NULL, NULL };
+	int n = 0;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-keyframe") == 0 && i + 1 < argc) {
+			keyframe = atof(argv[++i]);
+		} else if (strcmp(argv[i], "-list") == 0 && i + 1 < argc) {
+			list = argv[++i];
+		} else if (argv[i][0] != '-' && n < 2) {
+			paths[n++] = argv[i];
+		} else {
+			n = -1;
+			break;
+		}
+	}
+	if (list != NULL && n == 0) {
+		return List(list);
+	}
+	if (list != NULL || n != 2) {
+		fprintf(stderr, "usage: %s [-keyframe S] capture.rfcap archive.rfarc\n       %s -list archive.rfarc\n", argv[0], argv[0]);
+		return 1;
+	}
+	return Convert(paths[0], paths[1], keyframe);
+}
@@ -0,0 +1,136 @@
+/*
+ rfFields.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Generic reader driven by the schema map (see rfSchema): lists every
+ published struct and field with its offset, type, count and unit, or looks
+ paths up by name and prints their current values straight from the maps,
+ without knowing the struct layouts at compile time.
+
+ usage: rfFields                      list the schema
+        rfFields struct.path ...      print values, e.g. rfShared.speed or
+                                      rfVehicleSegment.vehicle[3].driverName
+*/
+
+#include "rfSharedReader.hpp"
+#include <stdio.h>
+#include <string.h>
+
+static const char *typeNames[] = {
+	"struct", "int8", "uint8", "int16", "int32", "uint32", "uint64", "float", "double", "char", "bool", "uint16"
+};
+
+static const char* TypeName(const rfSchema &schema, const rfSchemaField &f) {
+	if (f.type == schemaStruct) {
+		return f.ref < schema.numStructs ? schema.structs[f.ref].name : "?";
+	}
+	return f.type < sizeof(typeNames) / sizeof(typeNames[0]) ? typeNames[f.type] : "?";
+}
+
+static void List(const rfSchema &schema) {
+	for (uint32_t i = 0; i < schema.numStructs; i++) {
+		const rfSchemaStruct &s = schema.structs[i];
+		printf("%s (%u bytes)%s%s\n", s.name, s.size, s.map[0] ? " in " : "", s.map);
+		for (uint32_t j = s.firstField; j < (uint32_t)s.firstField + s.numFields; j++) {
+			const rfSchemaField &f = schema.field[j];
+			printf("  %6u %-24s %-18s %5u %s\n", f.offset, f.name, TypeName(schema, f), f.count, f.unit);
+		}
+	}
+}
+
+static void PrintElement(const rfSchemaField &f, const char *p) {
+	switch (f.type) {
+	case schemaInt8: printf("%d", *(const int8_t*)p); break;
+	case schemaUInt8: printf("%u", *(const uint8_t*)p); break;
+	case schemaInt16: printf("%d", *(const int16_t*)p); break;
+	case schemaUInt16: printf("%u", *(const uint16_t*)p); break;
+	case schemaInt32: printf("%d", *(const int32_t*)p); break;
+	case schemaUInt32: printf("%u", *(const uint32_t*)p); break;
+	case schemaUInt64: printf("%llu", (unsigned long long)*(const uint64_t*)p); break;
+	case schemaFloat: printf("%g", *(const float*)p); break;
+	case schemaDouble: printf("%.9g", *(const double*)p); break;
+	case schemaBool: printf("%s", *p ? "true" : "false"); break;
+	default: printf("?"); break;
+	}
+}
+
+// look path up as struct.member... and print it from the struct's map
+static bool Print(const rfSchema &schema, const char *path) {
+	const char *dot = strchr(path, '.');
+	char name[sizeof(schema.structs[0].name)] = {};
+	if (dot == NULL || (size_t)(dot - path) >= sizeof(name)) {
+		return false;
+	}
+	memcpy(name, path, dot - path);
+	int index = rfSchemaFindStruct(schema, name);
+	const rfSchemaField *f = NULL;
+	long offset = rfSchemaResolve(schema, name, dot + 1, &f);
+	if (offset < 0 || f->type == schemaStruct || schema.structs[index].map[0] == 0) {
+		return false;
+	}
+	// an indexed path is one element, otherwise the whole array
+	bool whole = path[strlen(path) - 1] != ']';
+	// only map up to the field, the vehicle segment is shorter than its struct
+	char tag[256];
+	rfMapName(tag, sizeof(tag), schema.structs[index].map);
+	rfMapping map;
+	const char *base = (const char*)rfMapCreate(map, tag, offset + (whole ? f->count : 1) * f->size);
+	if (base == NULL) {
+		return false;
+	}
+	printf("%s = ", path);
+	if (f->type == schemaChar) {
+		size_t room = whole ? f->count : 1;
+		printf("\"%.*s\"", (int)strnlen(base + offset, room), base + offset);
+	} else {
+		uint32_t count = whole ? f->count : 1;
+		printf(count > 1 ? "{ " : "");
+		for (uint32_t i = 0; i < count; i++) {
+			PrintElement(*f, base + offset + i * f->size);
+			printf(i + 1 < count ? ", " : "");
+		}
+		printf(count > 1 ? " }" : "");
+	}
+	printf(f->unit[0] ? " %s\n" : "\n", f->unit);
+	rfMapClose(map);
+	return true;
+}
+
+int main(int argc, char **argv) {
+	if (argc > 1 && argv[1][0] == '-') {
+		fprintf(stderr, "usage: %s [struct.path ...]\n", argv[0]);
+		return 1;
+	}
+	char tag[256];
+	rfMapName(tag, sizeof(tag), RF_SHARED_MEMORY_SCHEMA_NAME);
+	rfMapping map;
+	const rfSchema *src = (const rfSchema*)rfMapCreate(map, tag, sizeof(rfSchema));
+	if (src == NULL) {
+		fprintf(stderr, "unable to map %s\n", tag);
+		return 1;
+	}
+	static rfSchema schema;
+	if (!rfSeqSnapshot(src, &schema) || schema.numStructs == 0) {
+		fprintf(stderr, "no schema published in %s\n", tag);
+		rfMapClose(map);
+		return 1;
+	}
+	rfMapClose(map);
+	if (schema.numStructs > RF_SHARED_MEMORY_SCHEMA_STRUCTS || schema.numFields > RF_SHARED_MEMORY_SCHEMA_FIELDS) {
+		fprintf(stderr, "schema in %s is corrupt\n", tag);
+		return 1;
+	}
+	if (argc == 1) {
+		printf("schema %.8s\n", schema.version);
+		List(schema);
+		return 0;
+	}
+	int result = 0;
+	for (int i = 1; i < argc; i++) {
+		if (!Print(schema, argv[i])) {
+			fprintf(stderr, "%s doesn't resolve to a published member\n", argv[i]);
+			result = 1;
+		}
+	}
+	return result;
+}
@@ -0,0 +1,70 @@
+/*
+ rfReaders.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Lists the readers registered with the plugin (see rfReaderTable) and how far
+ behind each one is, refreshed every second, so a consumer that can't keep up
+ with the telemetry rate stands out.
+
+ usage: rfReaders [-once] [-interval S]
+*/
+
+#include "rfSharedReader.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+
+static void Print(const rfReaderTable *table) {
+	double now = rfClockSeconds();
+	printf("head %u\n", *(const volatile uint32_t*)&table->head);
+	printf("%4s %-24s %8s %8s %8s %9s %8s\n", "slot", "name", "pid", "lag", "maxLag", "overruns", "age (s)");
+	for (int i = 0; i < RF_SHARED_MEMORY_MAX_READERS; i++) {
+		const rfReaderSlot &slot = table->slot[i];
+		const rfReaderStatus &status = table->status[i];
+		double heartbeat = *(const volatile double*)&slot.heartbeat;
+		if (slot.owner == 0 || heartbeat == 0.0) {
+			continue;
+		}
+		// counters from the previous owner until the plugin's next telemetry update
+		bool current = status.owner == slot.owner;
+		printf("%4d %-24.24s %8u %8u %8u %9u %8.1f\n", i, slot.name, slot.pid,
+			current ? status.lag : 0, current ? status.maxLag : 0, current ? status.overruns : 0, now - heartbeat);
+	}
+}
+
+int main(int argc, char **argv) {
+	bool once = false;
+	double interval = 1.0;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-once") == 0) {
+			once = true;
+		} else if (strcmp(argv[i], "-interval") == 0 && i + 1 < argc) {
+			interval = atof(argv[++i]);
+		} else {
+			fprintf(stderr, "usage: %s [-once] [-interval S]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	char tag[256];
+	rfMapName(tag, sizeof(tag), RF_SHARED_MEMORY_READERS_NAME);
+	rfMapping map;
+	rfReaderTable *table = (rfReaderTable*)rfMapCreate(map, tag, sizeof(rfReaderTable));
+	if (table == NULL) {
+		fprintf(stderr, "unable to map %s\n", tag);
+		return 1;
+	}
+	for (;;) {
+		Print(table);
+		if (once) {
+			break;
+		}
+		printf("\n");
+		fflush(stdout);
+		std::this_thread::sleep_for(std::chrono::duration<double>(interval));
+	}
+	rfMapClose(map);
+	return 0;
+}
@@ -0,0 +1,429 @@
+/*
+ rfReplay.cpp
+ by Dan Allongo (daniel.s.allongo@gmail.com)
+
+ Replays a recorded session (see rfCapture.hpp) through SharedMemoryMapPlugin
+ without the sim, either as fast as possible or in real time, and reports
+ throughput and per-callback latency percentiles. With no capture file a
+ deterministic synthetic session is generated instead, so a baseline for a
+ full grid can be taken anywhere.
+
+ Seekable archives (see rfArchive.hpp) are replayed too, and can be started
+ part-way through with -lap (and -sector) or -et, within the session picked by
+ -session (counted from 0).
+
+ The plugin's own view of its latency, from the stats map, is printed too.
+
+ By default rfReplay also attaches to the map as a reader asking for vehicle
+ interpolation; -nosubscribe measures the plugin with no interested reader.
+ -wait adds a reader thread blocked on the telemetry signal and reports how
+ long after each publication it woke up (best used with -realtime).
+
+ usage: rfReplay [-realtime] [-nosubscribe] [-wait] [-cars N] [-seconds S] [capture.rfcap]
+        rfReplay [-realtime] [-nosubscribe] [-wait] [-session N] [-lap L [-sector S] | -et T] archive.rfarc
+*/
+
+#include "rFactorSharedMemoryMap.hpp"
+#include "rfArchive.hpp"
+#include "rfSharedReader.hpp"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock replayClock;
+
+struct replayEvent {
+	rfCaptureType type;
+	double time;                // seconds since session start
+	size_t offset;              // payload offset in replaySession::data
+	size_t size;                // payload size
+};
+
+struct replaySession {
+	std::vector<replayEvent> events;
+	std::vector<double> data;   // payload storage, double keeps every payload 8-byte aligned
+};
+
+static void AddEvent(replaySession &session, rfCaptureType type, double time, const void *payload, size_t size) {
+	replayEvent ev = { type, time, session.data.size() * sizeof(double), size };
+	session.data.resize(session.data.size() + (size + sizeof(double) - 1) / sizeof(double));
+	if (size > 0) {
+		memcpy((char*)session.data.data() + ev.offset, payload, size);
+	}
+	session.events.push_back(ev);
+}
+
+// add a recorded callback, its payload translated from rfCapture.hpp back into the sim's structs
+static void AddCaptureEvent(replaySession &session, rfCaptureType type, double time, const void *payload, size_t size) {
+	if (type == captureTelemetry && size >= sizeof(rfCaptureTelem)) {
+		TelemInfoV2 info;
+		rfCaptureToTelem(*(const rfCaptureTelem*)payload, info);
+		AddEvent(session, type, time, &info, sizeof(info));
+	} else if (type == captureScoring && size >= sizeof(rfCaptureScoring)) {
+		const rfCaptureScoring &capture = *(const rfCaptureScoring*)payload;
+		const rfCaptureVehicle *recorded = (const rfCaptureVehicle*)((const char*)payload + sizeof(rfCaptureScoring));
+		size_t n = (size - sizeof(rfCaptureScoring)) / sizeof(rfCaptureVehicle);
+		if (capture.mNumVehicles >= 0 && (size_t)capture.mNumVehicles < n) {
+			n = (size_t)capture.mNumVehicles;
+		}
+		std::vector<char> buf(sizeof(ScoringInfoV2) + n * sizeof(VehicleScoringInfoV2));
+		ScoringInfoV2 *info = (ScoringInfoV2*)buf.data();
+		VehicleScoringInfoV2 *veh = (VehicleScoringInfoV2*)(buf.data() + sizeof(ScoringInfoV2));
+		rfCaptureToScoring(capture, *info);
+		info->mNumVehicles = (long)n;
+		for (size_t i = 0; i < n; i++) {
+			rfCaptureToVehicle(recorded[i], veh[i]);
+		}
+		AddEvent(session, type, time, buf.data(), buf.size());
+	} else if (type != captureTelemetry && type != captureScoring) {
+		AddEvent(session, type, time, NULL, 0);
+	}
+}
+
+static bool LoadCapture(replaySession &session, const char *path) {
+	FILE *f = fopen(path, "rb");
+	if (f == NULL) {
+		fprintf(stderr, "unable to open %s\n", path);
+		return false;
+	}
+	rfCaptureHeader header;
+	if (fread(&header, sizeof(header), 1, f) != 1 || !rfCaptureCompatible(header)) {
+		fprintf(stderr, "%s is not a capture this build can replay\n", path);
+		fclose(f);
+		return false;
+	}
+	rfCaptureRecord record;
+	std::vector<char> payload;
+	while (fread(&record, sizeof(record), 1, f) == 1) {
+		payload.resize(record.size);
+		if (record.size > 0 && fread(payload.data(), record.size, 1, f) != 1) {
+			fprintf(stderr, "%s is truncated\n", path);
+			break;
+		}
+		AddCaptureEvent(session, (rfCaptureType)record.type, record.time, payload.data(), record.size);
+	}
+	fclose(f);
+	return true;
+}
+
+struct replaySeek {
+	unsigned int session;
+	int lap;                    // start at this lap if > 0
+	int sector;
+	double currentET;           // otherwise at this session time if >= 0
+};
+
+static bool LoadArchive(replaySession &session, const char *path, const replaySeek &seek) {
+	rfArchiveReader reader;
+	if (!reader.Open(path)) {
+		fprintf(stderr, "%s is not an archive this build can replay\n", path);
+		return false;
+	}
+	double start = 0.0;
+	if (seek.lap > 0 || seek.currentET >= 0.0) {
+		bool found = seek.lap > 0 ? reader.SeekLap(seek.session, seek.lap, seek.sector) :
+			reader.SeekET(seek.session, seek.currentET);
+		if (!found) {
+			fprintf(stderr, "unable to seek in %s\n", path);
+			return false;
+		}
+		// bring the plugin up to the keyframe's state, then carry on from there
+		const rfArchiveState &state = reader.State();
+		start = state.time;
+		printf("starting at %.3f s: session %u, lap %d, sector %d, currentET %.3f\n", state.time,
+			state.sessions ? state.sessions - 1 : 0, state.lap, state.sector, state.currentET);
+		if (state.flags & archiveInSession) {
+			AddEvent(session, captureStartSession, 0.0, NULL, 0);
+		}
+		if (state.flags & archiveInRealtime) {
+			AddEvent(session, captureEnterRealtime, 0.0, NULL, 0);
+		}
+		if (!state.scoring.empty()) {
+			AddCaptureEvent(session, captureScoring, 0.0, state.scoring.data(), state.scoring.size());
+		}
+		if (!state.telemetry.empty()) {
+			AddCaptureEvent(session, captureTelemetry, 0.0, state.telemetry.data(), state.telemetry.size());
+		}
+	}
+	rfCaptureRecord record;
+	const void *payload;
+	while (reader.Next(record, payload)) {
+		AddCaptureEvent(session, (rfCaptureType)record.type, record.time - start, payload, record.size);
+	}
+	return true;
+}
+
+// cars evenly spread around a 4 km circle, telemetry at 90 Hz and scoring at 2 Hz
+static void MakeSyntheticSession(replaySession &session, int cars, double seconds) {
+	const float trackLength = 4000.0f;
+	const float radius = trackLength / (2.0f * 3.14159265f);
+	std::vector<char> scoringBuf(sizeof(ScoringInfoV2) + cars * sizeof(VehicleScoringInfoV2));
+	ScoringInfoV2 *info = (ScoringInfoV2*)scoringBuf.data();
+	VehicleScoringInfoV2 *veh = (VehicleScoringInfoV2*)(scoringBuf.data() + sizeof(ScoringInfoV2));
+	TelemInfoV2 telem;
+	memset(&telem, 0, sizeof(telem));
+	strcpy(telem.mTrackName, "Synthetic Oval");
+	strcpy(telem.mVehicleName, "Synthetic Car");
+	for (int w = 0; w < 4; w++) {
+		strcpy(telem.mWheel[w].mTerrainName, "ROAD");
+	}
+
+	AddEvent(session, captureStartSession, 0.0, NULL, 0);
+	AddEvent(session, captureEnterRealtime, 0.0, NULL, 0);
+	int ticks = (int)(seconds * 90.0);
+	for (int tick = 0; tick <= ticks; tick++) {
+		double t = tick / 90.0;
+		if (tick % 45 == 0) {
+			memset(scoringBuf.data(), 0, scoringBuf.size());
+			strcpy(info->mTrackName, telem.mTrackName);
+			strcpy(info->mPlayerName, "Player");
+			strcpy(info->mPlrFileName, "Player");
+			info->mSession = 10;
+			info->mCurrentET = (float)t;
+			info->mEndET = (float)seconds;
+			info->mLapDist = trackLength;
+			info->mNumVehicles = cars;
+			info->mGamePhase = 5;
+			for (int i = 0; i < cars; i++) {
+				float speed = 50.0f + i * 0.1f;
+				float dist = fmodf(trackLength - i * (trackLength / cars) + speed * (float)t, trackLength);
+				float angle = dist / radius;
+				VehicleScoringInfoV2 &v = veh[i];
+				sprintf(v.mDriverName, "Driver %d", i + 1);
+				strcpy(v.mVehicleClass, i % 2 ? "GT2" : "GT1");
+				v.mIsPlayer = (i == 0);
+				v.mControl = (i == 0) ? 0 : 1;
+				v.mPlace = (unsigned char)(i + 1);
+				v.mTotalLaps = (short)(speed * t / trackLength);
+				v.mLapDist = dist;
+				v.mSector = dist < trackLength / 3.0f ? 1 : dist < trackLength * 2.0f / 3.0f ? 2 : 0;
+				v.mPos.Set(radius * sinf(angle), 0.0f, radius * cosf(angle));
+				// heading along the tangent, +z out of the back of the car, rolled
+				// into the banking and pitching and rolling a little on the way round
+				float bank = 0.05f + 0.01f * (i % 8);
+				v.mOriX.Set(cosf(angle) * cosf(bank), sinf(bank), -sinf(angle) * cosf(bank));
+				v.mOriY.Set(-cosf(angle) * sinf(bank), cosf(bank), sinf(angle) * sinf(bank));
+				v.mOriZ.Set(sinf(angle), 0.0f, cosf(angle));
+				v.mLocalVel.Set(0.0f, 0.0f, -speed);
+				v.mLocalAccel.Set(speed * speed / radius, 0.0f, 0.0f);
+				v.mLocalRot.Set(0.3f * sinf(3.0f * (float)t + i), speed / radius, 0.4f * cosf(2.0f * (float)t + i));
+			}
+			AddEvent(session, captureScoring, t, scoringBuf.data(), scoringBuf.size());
+		}
+		telem.mDeltaTime = 1.0f / 90.0f;
+		telem.mLapNumber = veh[0].mTotalLaps + 1;
+		telem.mPos = veh[0].mPos;
+		telem.mOriX = veh[0].mOriX;
+		telem.mOriY = veh[0].mOriY;
+		telem.mOriZ = veh[0].mOriZ;
+		telem.mLocalVel = veh[0].mLocalVel;
+		telem.mGear = 4;
+		telem.mEngineRPM = 7000.0f + 500.0f * sinf((float)t);
+		telem.mUnfilteredThrottle = 1.0f;
+		AddEvent(session, captureTelemetry, t, &telem, sizeof(telem));
+	}
+	AddEvent(session, captureExitRealtime, seconds, NULL, 0);
+	AddEvent(session, captureEndSession, seconds, NULL, 0);
+}
+
+static void Dispatch(SharedMemoryMapPlugin &plugin, const replaySession &session, const replayEvent &ev) {
+	const char *payload = (const char*)session.data.data() + ev.offset;
+	switch (ev.type) {
+		case captureStartSession: plugin.StartSession(); break;
+		case captureEndSession: plugin.EndSession(); break;
+		case captureEnterRealtime: plugin.EnterRealtime(); break;
+		case captureExitRealtime: plugin.ExitRealtime(); break;
+		case captureTelemetry:
+			plugin.UpdateTelemetry(*(const TelemInfoV2*)payload);
+			break;
+		case captureScoring: {
+			// pointers in the recorded struct are stale, point them at the recorded vehicles
+			ScoringInfoV2 info = *(const ScoringInfoV2*)payload;
+			info.mVehicle = (VehicleScoringInfoV2*)(payload + sizeof(ScoringInfoV2));
+			info.mResultsStream = NULL;
+			plugin.UpdateScoring(info);
+			break;
+		}
+	}
+}
+
+// a reader blocked on the telemetry signal, timing each wakeup against the frame's publication
+// registered in the reader table as "rfReplay -wait"
+static void Waiter(rfShared *map, rfReaderTable *table, std::atomic<bool> *done, std::vector<double> *wakeups) {
+	rfSignal signal;
+	rfSharedOpenSignal(signal, map);
+	rfReaderRegistration reg = { table, -1, 0 };
+	if (table) {
+		rfReaderRegister(reg, table, "rfReplay -wait");
+	}
+	uint32_t last = map->telemetrySignal;
+	while (!done->load()) {
+		if (rfSignalWait(signal, last, 0.1)) {
+			double now = rfClockSeconds();
+			last = map->telemetrySignal;
+			wakeups->push_back((now - *(volatile double*)&map->telemetryTime) * 1e6);
+		}
+		if (table) {
+			rfReaderConsume(reg, *(volatile uint32_t*)&table->head);
+		}
+	}
+	if (table) {
+		rfReaderUnregister(reg);
+	}
+	rfSignalClose(signal);
+}
+
+static double Percentile(const std::vector<double> &sorted, double p) {
+	if (sorted.empty()) {
+		return 0.0;
+	}
+	size_t i = (size_t)(p * (sorted.size() - 1) + 0.5);
+	return sorted[i];
+}
+
+int main(int argc, char **argv) {
+	bool realtime = false;
+	bool subscribe = true;
+	bool wait = false;
+	int cars = RF_SHARED_MEMORY_MAX_VSI_SIZE;
+	double seconds = 60.0;
+	const char *path = NULL;
+	replaySeek seek = { 0, 0, 1, -1.0 };
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-realtime") == 0) {
+			realtime = true;
+		} else if (strcmp(argv[i], "-nosubscribe") == 0) {
+			subscribe = false;
+		} else if (strcmp(argv[i], "-wait") == 0) {
+			wait = true;
+		} else if (strcmp(argv[i], "-cars") == 0 && i + 1 < argc) {
+			cars = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-seconds") == 0 && i + 1 < argc) {
+			seconds = atof(argv[++i]);
+		} else if (strcmp(argv[i], "-session") == 0 && i + 1 < argc) {
+			seek.session = (unsigned int)atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-lap") == 0 && i + 1 < argc) {
+			seek.lap = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-sector") == 0 && i + 1 < argc) {
+			seek.sector = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-et") == 0 && i + 1 < argc) {
+			seek.currentET = atof(argv[++i]);
+		} else if (argv[i][0] != '-') {
+			path = argv[i];
+		} else {
+			fprintf(stderr, "usage: %s [-realtime] [-nosubscribe] [-wait] [-cars N] [-seconds S] [capture.rfcap]\n"
+				"       %s [-realtime] [-nosubscribe] [-wait] [-session N] [-lap L [-sector S] | -et T] archive.rfarc\n", argv[0], argv[0]);
+			return 1;
+		}
+	}
+
+	replaySession session;
+	if (path) {
+		if (rfArchiveDetect(path) ? !LoadArchive(session, path, seek) : !LoadCapture(session, path)) {
+			return 1;
+		}
+	} else {
+		MakeSyntheticSession(session, cars, seconds);
+	}
+
+	SharedMemoryMapPlugin plugin;
+	plugin.Startup();
+
+	// attach like any other reader would
+	char tag[256];
+	rfMapName(tag, sizeof(tag), RF_SHARED_MEMORY_NAME);
+	rfMapping readerMap;
+	rfShared *reader = (rfShared*)rfMapCreate(readerMap, tag, sizeof(rfShared));
+
+	char statsTag[256];
+	rfMapName(statsTag, sizeof(statsTag), RF_SHARED_MEMORY_STATS_NAME);
+	rfMapping statsMap;
+	rfStats *stats = (rfStats*)rfMapCreate(statsMap, statsTag, sizeof(rfStats));
+
+	char readersTag[256];
+	rfMapName(readersTag, sizeof(readersTag), RF_SHARED_MEMORY_READERS_NAME);
+	rfMapping readersMap;
+	rfReaderTable *readers = (rfReaderTable*)rfMapCreate(readersMap, readersTag, sizeof(rfReaderTable));
+
+	std::atomic<bool> done(false);
+	std::vector<double> wakeups;
+	std::thread waiter;
+	if (wait && reader) {
+		waiter = std::thread(Waiter, reader, readers, &done, &wakeups);
+	}
+
+	std::vector<double> latency[captureScoring + 1];
+	replayClock::time_point start = replayClock::now();
+	for (size_t i = 0; i < session.events.size(); i++) {
+		const replayEvent &ev = session.events[i];
+		if (realtime) {
+			std::this_thread::sleep_until(start + std::chrono::duration_cast<replayClock::duration>(std::chrono::duration<double>(ev.time)));
+		}
+		if (subscribe && reader && ev.type == captureTelemetry) {
+			rfSharedSubscribe(reader, readerVehicleInterpolation);
+		}
+		replayClock::time_point before = replayClock::now();
+		Dispatch(plugin, session, ev);
+		replayClock::time_point after = replayClock::now();
+		if (ev.type <= captureScoring) {
+			latency[ev.type].push_back(std::chrono::duration<double, std::micro>(after - before).count());
+		}
+	}
+	double elapsed = std::chrono::duration<double>(replayClock::now() - start).count();
+	if (waiter.joinable()) {
+		done = true;
+		waiter.join();
+	}
+
+	rfStats pluginStats;
+	bool haveStats = stats && rfSeqSnapshot(stats, &pluginStats);
+	rfMapClose(statsMap);
+	rfMapClose(readersMap);
+	rfMapClose(readerMap);
+	plugin.Shutdown();
+
+	static const char *names[] = { "StartSession", "EndSession", "EnterRealtime", "ExitRealtime", "UpdateTelemetry", "UpdateScoring" };
+	size_t frames = latency[captureTelemetry].size();
+	printf("replayed %u events in %.3f s, %.0f telemetry frames/sec\n",
+		(unsigned)session.events.size(), elapsed, elapsed > 0.0 ? frames / elapsed : 0.0);
+	printf("%-16s %8s %9s %9s %9s %9s %9s  (microseconds)\n", "callback", "calls", "p50", "p90", "p99", "p99.9", "max");
+	for (int t = 0; t <= captureScoring; t++) {
+		std::vector<double> &l = latency[t];
+		if (l.empty()) {
+			continue;
+		}
+		std::sort(l.begin(), l.end());
+		printf("%-16s %8u %9.2f %9.2f %9.2f %9.2f %9.2f\n", names[t], (unsigned)l.size(),
+			Percentile(l, 0.5), Percentile(l, 0.9), Percentile(l, 0.99), Percentile(l, 0.999), l.back());
+	}
+	if (!wakeups.empty()) {
+		std::sort(wakeups.begin(), wakeups.end());
+		printf("%-16s %8u %9.2f %9.2f %9.2f %9.2f %9.2f\n", "reader wakeup", (unsigned)wakeups.size(),
+			Percentile(wakeups, 0.5), Percentile(wakeups, 0.9), Percentile(wakeups, 0.99), Percentile(wakeups, 0.999), wakeups.back());
+	}
+	if (haveStats) {
+		static const char *probes[] = { "UpdateTelemetry", "UpdateScoring", "Interpolation" };
+		printf("\nplugin stats at %.0f MHz     calls  p50 <=    p99 <=       max  (microseconds)\n", pluginStats.cyclesPerSecond * 1e-6);
+		for (int p = 0; p < probeCount; p++) {
+			const rfLatencyStats &s = pluginStats.probe[p];
+			printf("%-24s %8llu %9.2f %9.2f %9.2f\n", probes[p], (unsigned long long)s.calls,
+				rfStatsPercentile(pluginStats, (rfStatsProbe)p, 0.5) * 1e6, rfStatsPercentile(pluginStats, (rfStatsProbe)p, 0.99) * 1e6,
+				pluginStats.cyclesPerSecond > 0.0 ? s.maxCycles / pluginStats.cyclesPerSecond * 1e6 : 0.0);
+		}
+		if (pluginStats.vehiclesUnmapped) {
+			printf("\n%s couldn't be mapped, the plugin ran without it\n", RF_SHARED_MEMORY_VEHICLES_NAME);
+		}
+		if (pluginStats.recordedRecords > 0) {
+			printf("\nrecorded %llu records (%llu dropped), %llu bytes%s\n", (unsigned long long)pluginStats.recordedRecords,
+				(unsigned long long)pluginStats.droppedRecords, (unsigned long long)pluginStats.recordedBytes,
+				pluginStats.recordFailed ? ", capture file couldn't be grown" : "");
+		}
+	}
+	return 0;
+}